@@ -0,0 +1,284 @@
+// Headless Game of Life throughput benchmark
+// runs every stepping engine in LifeGrid.hpp over the same starting boards and
+// checks that they all end up with the same population, plus the parallel engine
+// drawing the board texture pixels (LifeImage.hpp) after every generation
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "DataStructure/LifeGrid.hpp"
+#include "DataStructure/LifeImage.hpp"
+
+struct BenchOptions
+{
+    std::vector<int> sizes = {256, 1024, 4096, 16384};
+    std::vector<std::string> patterns = {"soup", "r-pentomino", "acorn"};
+    int generations = 0; // 0 picks a count from the board size
+    unsigned int seed = 1;
+    unsigned int threads = std::thread::hardware_concurrency();
+    float density = 0.35f;
+};
+
+struct EngineResult
+{
+    std::string name;
+    bool ran = false;
+    double seconds = 0.0;
+    size_t population = 0;
+    size_t boardBytes = 0;
+    long peakKB = 0;
+};
+
+static std::vector<std::string> Split(const std::string &_text)
+{
+    std::vector<std::string> parts;
+    size_t start = 0;
+    while (start <= _text.size())
+    {
+        size_t end = _text.find(',', start);
+        if (end == std::string::npos)
+            end = _text.size();
+        if (end > start)
+            parts.push_back(_text.substr(start, end - start));
+        start = end + 1;
+    }
+    return parts;
+}
+
+// lets every engine report its own high water mark instead of the largest one so far
+static void ResetPeakMemory()
+{
+#ifdef __linux__
+    std::ofstream clearRefs("/proc/self/clear_refs");
+    if (clearRefs)
+        clearRefs << "5";
+#endif
+}
+
+static long PeakMemoryKB()
+{
+#ifdef __linux__
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line))
+        if (line.rfind("VmHWM:", 0) == 0)
+            return std::atol(line.c_str() + 6);
+#endif
+    return 0;
+}
+
+static void Stamp(LifeGrid::Board &_board, const std::vector<std::pair<int, int>> &_cells)
+{
+    int cx = _board.width / 2;
+    int cy = _board.height / 2;
+    for (auto [x, y] : _cells)
+        LifeGrid::Set(_board, cx + x, cy + y, true);
+}
+
+static bool Seed(LifeGrid::Board &_board, const std::string &_pattern, const BenchOptions &_options, int _size)
+{
+    LifeGrid::Init(_board, _size, _size);
+
+    if (_pattern == "soup")
+    {
+        std::mt19937_64 random(_options.seed);
+        std::bernoulli_distribution alive(_options.density);
+        for (uint8_t &cell : _board.cells)
+            cell = alive(random);
+        return true;
+    }
+
+    if (_pattern == "r-pentomino")
+    {
+        Stamp(_board, {{1, 0}, {2, 0}, {0, 1}, {1, 1}, {1, 2}});
+        return true;
+    }
+
+    if (_pattern == "acorn")
+    {
+        Stamp(_board, {{1, 0}, {3, 1}, {0, 2}, {1, 2}, {4, 2}, {5, 2}, {6, 2}});
+        return true;
+    }
+
+    return false;
+}
+
+template <typename StepFunction>
+static EngineResult Run(const char *_name, int _generations, size_t _boardBytes, StepFunction _step)
+{
+    EngineResult result;
+    result.name = _name;
+    result.ran = true;
+    result.boardBytes = _boardBytes;
+
+    ResetPeakMemory();
+
+    auto start = std::chrono::steady_clock::now();
+    for (int g = 0; g < _generations; g++)
+        _step();
+    auto end = std::chrono::steady_clock::now();
+
+    result.seconds = std::chrono::duration<double>(end - start).count();
+    result.peakKB = PeakMemoryKB();
+    return result;
+}
+
+int main(int argc, char *argv[])
+{
+    BenchOptions options;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        const char *value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+
+        if (arg == "--sizes" && value)
+        {
+            options.sizes.clear();
+            for (const std::string &size : Split(value))
+                options.sizes.push_back(std::atoi(size.c_str()));
+            i++;
+        }
+        else if (arg == "--patterns" && value)
+        {
+            options.patterns = Split(value);
+            i++;
+        }
+        else if (arg == "--generations" && value)
+        {
+            options.generations = std::atoi(value);
+            i++;
+        }
+        else if (arg == "--seed" && value)
+        {
+            options.seed = std::strtoul(value, nullptr, 10);
+            i++;
+        }
+        else if (arg == "--threads" && value)
+        {
+            options.threads = std::strtoul(value, nullptr, 10);
+            i++;
+        }
+        else if (arg == "--density" && value)
+        {
+            options.density = std::atof(value);
+            i++;
+        }
+        else
+        {
+            std::printf("usage: life_bench [--sizes 256,1024,...] [--patterns soup,r-pentomino,acorn]\n"
+                        "                  [--generations N] [--seed S] [--threads T] [--density D]\n");
+            return (arg == "--help") ? 0 : 1;
+        }
+    }
+
+    if (options.threads == 0)
+        options.threads = 1;
+
+    bool allMatch = true;
+
+    std::printf("%-12s %7s %6s %-10s %10s %14s %10s %10s %12s\n",
+                "pattern", "size", "gens", "engine", "gen/s", "cells/s", "board MB", "peak MB", "population");
+
+    for (int size : options.sizes)
+    {
+        // keep roughly the same amount of work per board, the reference engine is slow on the big ones
+        int generations = options.generations;
+        if (generations <= 0)
+            generations = std::clamp((int)((size_t(1) << 28) / ((size_t)size * size)), 4, 1000);
+
+        for (const std::string &pattern : options.patterns)
+        {
+            LifeGrid::Board start;
+            if (!Seed(start, pattern, options, size))
+            {
+                std::printf("unknown pattern %s\n", pattern.c_str());
+                return 1;
+            }
+
+            std::vector<EngineResult> results;
+            size_t byteBoardBytes = start.cells.size() * 2;
+
+            {
+                LifeGrid::Board board = start;
+                results.push_back(Run("reference", generations, byteBoardBytes, [&]() { LifeGrid::StepReference(board); }));
+                results.back().population = LifeGrid::Population(board);
+            }
+
+            {
+                LifeGrid::Board board = start;
+                results.push_back(Run("rows", generations, byteBoardBytes, [&]() { LifeGrid::Step(board); }));
+                results.back().population = LifeGrid::Population(board);
+            }
+
+            // started once like the app does, the rows below only pay for waking them
+            LifeGrid::Workers workers;
+            LifeGrid::StartWorkers(workers, options.threads);
+
+            {
+                LifeGrid::Board board = start;
+                results.push_back(Run("parallel", generations, byteBoardBytes, [&]() { LifeGrid::StepParallel(board, workers); }));
+                results.back().population = LifeGrid::Population(board);
+            }
+
+            // one pixel per cell, what a board this size gets on screen
+            bool imageMatches = true;
+            {
+                LifeGrid::Board board = start;
+                LifeImage::Image image;
+                LifeImage::Init(image, size, size, 1);
+                size_t imageBytes = byteBoardBytes + image.pixels.size() * sizeof(uint32_t) + image.shown.size();
+
+                results.push_back(Run("image", generations, imageBytes, [&]() {
+                    LifeGrid::StepParallel(board, workers);
+                    LifeImage::Update(image, board, workers);
+                    LifeImage::ClearDirty(image);
+                }));
+                results.back().population = LifeGrid::Population(board);
+                imageMatches = LifeImage::Matches(image, board);
+            }
+
+            if (LifeGrid::Supports(size))
+            {
+                LifeGrid::BitBoard bits;
+                LifeGrid::Pack(bits, start);
+                results.push_back(Run("bitpacked", generations, bits.words.size() * sizeof(uint64_t) * 2, [&]() { LifeGrid::Step(bits); }));
+                results.back().population = LifeGrid::Population(bits);
+            }
+
+            double cells = (double)size * size;
+            for (const EngineResult &result : results)
+            {
+                double genPerSecond = generations / result.seconds;
+                std::printf("%-12s %7d %6d %-10s %10.1f %14.3e %10.1f %10.1f %12zu\n",
+                            pattern.c_str(), size, generations, result.name.c_str(),
+                            genPerSecond, genPerSecond * cells,
+                            result.boardBytes / (1024.0 * 1024.0), result.peakKB / 1024.0,
+                            result.population);
+
+                if (result.name == "image" && !imageMatches)
+                {
+                    std::printf("MISMATCH: image pixels differ from a full redraw\n");
+                    allMatch = false;
+                }
+
+                if (result.population != results[0].population)
+                {
+                    std::printf("MISMATCH: %s population %zu, reference %zu\n",
+                                result.name.c_str(), result.population, results[0].population);
+                    allMatch = false;
+                }
+            }
+        }
+    }
+
+    return allMatch ? 0 : 1;
+}
@@ -0,0 +1,402 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+// Uniform grid the flock is indexed in, kept up to date incrementally.
+//
+// Every boid owns a stable slot. Cells are intrusive doubly linked lists of slots, so a boid that
+// crossed into another cell is unlinked and relinked in O(1) and boids that stayed put cost
+// nothing. Positions and velocities are double buffered: queries read the frame start state
+// while the step writes the next one.
+//
+// Relinking slowly scatters each cell's slots through memory. Once enough boids crossed, Rebalance
+// renumbers the slots in cell order so neighbours are close together again.
+//
+// For large perception radii Aggregate sums every cell into a pyramid of coarser levels, each node
+// holding the count, summed position and summed velocity of the boids under it. ForEachNearFar
+// then treats distant nodes as a single heavy boid (Barnes-Hut style).
+namespace BoidGrid
+{
+    const int32_t EMPTY = -1;
+
+    // levels of the pyramid, a grid of up to 2^31 cells a side fits
+    const int MAX_LEVELS = 32;
+
+    struct CellSum
+    {
+        int32_t count = 0;
+        glm::vec2 position = glm::vec2(0.0f);
+        glm::vec2 velocity = glm::vec2(0.0f);
+    };
+
+    struct Level
+    {
+        int width = 0;
+        int height = 0;
+        std::vector<CellSum> sums = {};
+    };
+
+    struct GridData
+    {
+        glm::vec2 origin = glm::vec2(0.0f); // min corner
+        float cellSize = 1.0f;
+        float inverseCellSize = 1.0f;
+        int width = 0;
+        int height = 0;
+
+        std::vector<int32_t> cellHead = {};
+        std::vector<int32_t> next = {};
+        std::vector<int32_t> prev = {};
+        std::vector<int32_t> slotCell = {};
+
+        std::vector<glm::vec2> positions = {};
+        std::vector<glm::vec2> velocities = {};
+        std::vector<glm::vec2> nextPositions = {};
+        std::vector<glm::vec2> nextVelocities = {};
+
+        // scratch for Rebalance, sized with the slots so a rebalance never allocates
+        std::vector<uint32_t> order = {};
+        std::vector<int32_t> cellStart = {};
+
+        uint64_t crossingsSinceRebalance = 0;
+
+        // levels[0] matches the cells, every level above halves the resolution down to one node
+        std::vector<Level> levels = {};
+    };
+
+    inline void Init(GridData &_grid, glm::vec2 _center, float _halfSize, float _cellSize)
+    {
+        _grid.cellSize = _cellSize;
+        _grid.inverseCellSize = 1.0f / _cellSize;
+        _grid.width = (int)std::ceil((_halfSize * 2.0f) / _cellSize);
+        _grid.height = _grid.width;
+        _grid.origin = _center - glm::vec2(_grid.width * _cellSize * 0.5f);
+        _grid.cellHead.assign((size_t)_grid.width * _grid.height, EMPTY);
+        _grid.cellStart.assign((size_t)_grid.width * _grid.height + 1, 0);
+
+        _grid.levels.clear();
+        int width = _grid.width;
+        int height = _grid.height;
+        while (true)
+        {
+            Level level;
+            level.width = width;
+            level.height = height;
+            level.sums.resize((size_t)width * height);
+            _grid.levels.push_back(std::move(level));
+
+            if (width == 1 && height == 1)
+                break;
+
+            width = (width + 1) / 2;
+            height = (height + 1) / 2;
+        }
+    }
+
+    inline size_t Size(const GridData &_grid)
+    {
+        return _grid.positions.size();
+    }
+
+    inline int CellX(const GridData &_grid, float _x)
+    {
+        return std::clamp((int)std::floor((_x - _grid.origin.x) * _grid.inverseCellSize), 0, _grid.width - 1);
+    }
+
+    inline int CellY(const GridData &_grid, float _y)
+    {
+        return std::clamp((int)std::floor((_y - _grid.origin.y) * _grid.inverseCellSize), 0, _grid.height - 1);
+    }
+
+    // anything outside the grid lands in the nearest edge cell
+    inline int32_t CellIndex(const GridData &_grid, glm::vec2 _position)
+    {
+        return CellY(_grid, _position.y) * _grid.width + CellX(_grid, _position.x);
+    }
+
+    inline void Link(GridData &_grid, int32_t _slot, int32_t _cell)
+    {
+        int32_t head = _grid.cellHead[_cell];
+        _grid.prev[_slot] = EMPTY;
+        _grid.next[_slot] = head;
+        if (head != EMPTY)
+            _grid.prev[head] = _slot;
+        _grid.cellHead[_cell] = _slot;
+        _grid.slotCell[_slot] = _cell;
+    }
+
+    inline void Unlink(GridData &_grid, int32_t _slot)
+    {
+        int32_t prev = _grid.prev[_slot];
+        int32_t next = _grid.next[_slot];
+
+        if (prev != EMPTY)
+            _grid.next[prev] = next;
+        else
+            _grid.cellHead[_grid.slotCell[_slot]] = next;
+
+        if (next != EMPTY)
+            _grid.prev[next] = prev;
+    }
+
+    // appends a slot, returns its index
+    inline int32_t Add(GridData &_grid, glm::vec2 _position, glm::vec2 _velocity)
+    {
+        int32_t slot = (int32_t)_grid.positions.size();
+
+        _grid.positions.push_back(_position);
+        _grid.velocities.push_back(_velocity);
+        _grid.nextPositions.push_back(_position);
+        _grid.nextVelocities.push_back(_velocity);
+        _grid.next.push_back(EMPTY);
+        _grid.prev.push_back(EMPTY);
+        _grid.slotCell.push_back(EMPTY);
+        _grid.order.push_back(0);
+
+        Link(_grid, slot, CellIndex(_grid, _position));
+        return slot;
+    }
+
+    inline void Reserve(GridData &_grid, size_t _count)
+    {
+        _grid.positions.reserve(_count);
+        _grid.velocities.reserve(_count);
+        _grid.nextPositions.reserve(_count);
+        _grid.nextVelocities.reserve(_count);
+        _grid.next.reserve(_count);
+        _grid.prev.reserve(_count);
+        _grid.slotCell.reserve(_count);
+        _grid.order.reserve(_count);
+    }
+
+    // drops every slot but keeps the capacity, for callers that rebuild the grid each frame
+    inline void Clear(GridData &_grid)
+    {
+        std::fill(_grid.cellHead.begin(), _grid.cellHead.end(), EMPTY);
+        _grid.positions.clear();
+        _grid.velocities.clear();
+        _grid.nextPositions.clear();
+        _grid.nextVelocities.clear();
+        _grid.next.clear();
+        _grid.prev.clear();
+        _grid.slotCell.clear();
+        _grid.order.clear();
+        _grid.crossingsSinceRebalance = 0;
+    }
+
+    // true when the next position of _slot left the slot's cell
+    inline bool Crossed(const GridData &_grid, int32_t _slot)
+    {
+        return CellIndex(_grid, _grid.nextPositions[_slot]) != _grid.slotCell[_slot];
+    }
+
+    // makes the state the step wrote the current one
+    inline void Swap(GridData &_grid)
+    {
+        _grid.positions.swap(_grid.nextPositions);
+        _grid.velocities.swap(_grid.nextVelocities);
+    }
+
+    // after Swap, moves the slots in _crossed to their new cells, nothing else is touched
+    template <typename SlotList>
+    inline void Relocate(GridData &_grid, const SlotList &_crossed)
+    {
+        for (int32_t slot : _crossed)
+        {
+            int32_t cell = CellIndex(_grid, _grid.positions[slot]);
+            if (cell == _grid.slotCell[slot])
+                continue;
+
+            Unlink(_grid, slot);
+            Link(_grid, slot, cell);
+            _grid.crossingsSinceRebalance++;
+        }
+    }
+
+    // calls _function(slot) for every slot in a cell overlapping the square around
+    // _position, the caller does the exact distance test
+    template <typename Function>
+    inline void ForEachNear(const GridData &_grid, glm::vec2 _position, float _radius, Function _function)
+    {
+        int minX = CellX(_grid, _position.x - _radius);
+        int maxX = CellX(_grid, _position.x + _radius);
+        int minY = CellY(_grid, _position.y - _radius);
+        int maxY = CellY(_grid, _position.y + _radius);
+
+        for (int y = minY; y <= maxY; y++)
+        {
+            for (int x = minX; x <= maxX; x++)
+                for (int32_t slot = _grid.cellHead[y * _grid.width + x]; slot != EMPTY; slot = _grid.next[slot])
+                    _function(slot);
+        }
+    }
+
+    // refreshes every level of the pyramid from the current positions
+    inline void Aggregate(GridData &_grid)
+    {
+        Level &cells = _grid.levels[0];
+        std::fill(cells.sums.begin(), cells.sums.end(), CellSum());
+
+        for (size_t slot = 0; slot < Size(_grid); slot++)
+        {
+            CellSum &sum = cells.sums[_grid.slotCell[slot]];
+            sum.count++;
+            sum.position += _grid.positions[slot];
+            sum.velocity += _grid.velocities[slot];
+        }
+
+        for (size_t l = 1; l < _grid.levels.size(); l++)
+        {
+            const Level &below = _grid.levels[l - 1];
+            Level &level = _grid.levels[l];
+
+            for (int y = 0; y < level.height; y++)
+            {
+                for (int x = 0; x < level.width; x++)
+                {
+                    CellSum sum;
+                    for (int child = 0; child < 4; child++)
+                    {
+                        int childX = x * 2 + (child & 1);
+                        int childY = y * 2 + (child >> 1);
+                        if (childX >= below.width || childY >= below.height)
+                            continue;
+
+                        const CellSum &childSum = below.sums[childY * below.width + childX];
+                        sum.count += childSum.count;
+                        sum.position += childSum.position;
+                        sum.velocity += childSum.velocity;
+                    }
+                    level.sums[y * level.width + x] = sum;
+                }
+            }
+        }
+    }
+
+    // like ForEachNear, but a node that looks smaller than _theta from _position is handed to
+    // _far(sum) as a whole instead of being opened. Nodes closer than _nearRadius are always
+    // opened so anything inside it reaches _near(slot) exactly. A node that lies entirely inside
+    // _wholeRadius is taken whole too, pass the smallest radius _far tests so the sums are exact
+    // for each of them. _theta 0 opens everything.
+    template <typename NearFunction, typename FarFunction>
+    inline void ForEachNearFar(const GridData &_grid, glm::vec2 _position, float _radius, float _nearRadius, float _wholeRadius,
+                               float _theta, NearFunction _near, FarFunction _far)
+    {
+        struct Node
+        {
+            int level;
+            int x;
+            int y;
+        };
+
+        // at most 3x3 starting nodes, and going one level down replaces a node with 4 children,
+        // so depth first never holds more than 9 + 3 per level below the start
+        const int STACK_SIZE = 9 + 3 * MAX_LEVELS;
+        Node stack[STACK_SIZE];
+        int stackSize = 0;
+
+        // start at the finest level whose nodes are at least as big as the radius, at most 3x3 of them overlap
+        int start = 0;
+        while (start + 1 < (int)_grid.levels.size() && _grid.cellSize * (1 << start) < _radius)
+            start++;
+
+        float startSize = _grid.cellSize * (1 << start);
+        const Level &top = _grid.levels[start];
+        int minX = std::clamp((int)std::floor((_position.x - _radius - _grid.origin.x) / startSize), 0, top.width - 1);
+        int maxX = std::clamp((int)std::floor((_position.x + _radius - _grid.origin.x) / startSize), 0, top.width - 1);
+        int minY = std::clamp((int)std::floor((_position.y - _radius - _grid.origin.y) / startSize), 0, top.height - 1);
+        int maxY = std::clamp((int)std::floor((_position.y + _radius - _grid.origin.y) / startSize), 0, top.height - 1);
+
+        for (int y = minY; y <= maxY; y++)
+            for (int x = minX; x <= maxX; x++)
+                stack[stackSize++] = Node{start, x, y};
+
+        while (stackSize > 0)
+        {
+            Node node = stack[--stackSize];
+            const Level &level = _grid.levels[node.level];
+            const CellSum &sum = level.sums[node.y * level.width + node.x];
+
+            if (sum.count == 0)
+                continue;
+
+            float size = _grid.cellSize * (1 << node.level);
+            glm::vec2 min = _grid.origin + glm::vec2(node.x * size, node.y * size);
+            glm::vec2 closest = glm::vec2(std::clamp(_position.x, min.x, min.x + size), std::clamp(_position.y, min.y, min.y + size));
+            float boxDistance = glm::distance(_position, closest);
+
+            if (boxDistance > _radius)
+                continue;
+
+            if (node.level == 0)
+            {
+                for (int32_t slot = _grid.cellHead[node.y * _grid.width + node.x]; slot != EMPTY; slot = _grid.next[slot])
+                    _near(slot);
+                continue;
+            }
+
+            glm::vec2 farthest = glm::vec2(std::max(std::abs(_position.x - min.x), std::abs(_position.x - min.x - size)),
+                                           std::max(std::abs(_position.y - min.y), std::abs(_position.y - min.y - size)));
+            bool inside = glm::length(farthest) <= _wholeRadius;
+
+            if (_theta > 0.0f && boxDistance > _nearRadius &&
+                (inside || size < _theta * glm::distance(_position, sum.position / (float)sum.count)))
+            {
+                _far(sum);
+                continue;
+            }
+
+            const Level &below = _grid.levels[node.level - 1];
+            for (int child = 0; child < 4; child++)
+            {
+                int childX = node.x * 2 + (child & 1);
+                int childY = node.y * 2 + (child >> 1);
+                if (childX < below.width && childY < below.height)
+                    stack[stackSize++] = Node{node.level - 1, childX, childY};
+            }
+        }
+    }
+
+    inline bool NeedsRebalance(const GridData &_grid)
+    {
+        return _grid.crossingsSinceRebalance > Size(_grid) / 4;
+    }
+
+    // renumbers the slots in cell order, _permute(order) has to move any per slot data the caller
+    // keeps, order[newSlot] is the old slot
+    template <typename Permute>
+    inline void Rebalance(GridData &_grid, Permute _permute)
+    {
+        size_t cellCount = _grid.cellHead.size();
+        size_t count = Size(_grid);
+
+        std::fill(_grid.cellStart.begin(), _grid.cellStart.end(), 0);
+        for (size_t slot = 0; slot < count; slot++)
+            _grid.cellStart[_grid.slotCell[slot] + 1]++;
+        for (size_t cell = 0; cell < cellCount; cell++)
+            _grid.cellStart[cell + 1] += _grid.cellStart[cell];
+        for (size_t slot = 0; slot < count; slot++)
+            _grid.order[_grid.cellStart[_grid.slotCell[slot]]++] = (uint32_t)slot;
+
+        // next buffers are free between frames so they double as the gather target
+        for (size_t slot = 0; slot < count; slot++)
+        {
+            _grid.nextPositions[slot] = _grid.positions[_grid.order[slot]];
+            _grid.nextVelocities[slot] = _grid.velocities[_grid.order[slot]];
+        }
+        _grid.positions.swap(_grid.nextPositions);
+        _grid.velocities.swap(_grid.nextVelocities);
+
+        _permute(_grid.order);
+
+        std::fill(_grid.cellHead.begin(), _grid.cellHead.end(), EMPTY);
+        for (int32_t slot = (int32_t)count - 1; slot >= 0; slot--)
+            Link(_grid, slot, CellIndex(_grid, _grid.positions[slot]));
+
+        _grid.crossingsSinceRebalance = 0;
+    }
+}
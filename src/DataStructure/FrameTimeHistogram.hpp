@@ -0,0 +1,134 @@
+#pragma once
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <vector>
+
+// Fixed memory frame time histogram with log linear (HDR style) buckets.
+//
+// Values are recorded in microseconds. Below 64us every microsecond has its own bucket, above
+// that each power of two is split into 32 buckets so any reading is within about 3%.
+// A ring of the last windowSize bucket indices keeps a second histogram for the rolling window,
+// the all time histogram is kept for export.
+class FrameTimeHistogram
+{
+public:
+    static constexpr int SUB_BUCKET_BITS = 5;
+    static constexpr int SUB_BUCKET_COUNT = 1 << SUB_BUCKET_BITS;
+    static constexpr uint32_t MAX_MICROSECONDS = (1u << 26) - 1; // ~67 seconds
+    static constexpr int BUCKET_COUNT = (26 - SUB_BUCKET_BITS + 1) * SUB_BUCKET_COUNT;
+
+private:
+    uint32_t m_totalCounts[BUCKET_COUNT] = {};
+    uint32_t m_windowCounts[BUCKET_COUNT] = {};
+    std::vector<uint16_t> m_window = {};
+    size_t m_windowNext = 0;
+    size_t m_windowFilled = 0;
+    uint64_t m_totalSamples = 0;
+    uint32_t m_totalMax = 0;
+
+    uint32_t Percentile(const uint32_t *_counts, uint64_t _samples, float _percentile) const
+    {
+        if (_samples == 0)
+            return 0;
+
+        uint64_t target = std::max<uint64_t>(1, (uint64_t)(_samples * (_percentile / 100.0f) + 0.5f));
+        uint64_t seen = 0;
+
+        for (int i = 0; i < BUCKET_COUNT; i++)
+        {
+            seen += _counts[i];
+            if (seen >= target)
+                return BucketUpper(i);
+        }
+        return MAX_MICROSECONDS;
+    }
+
+public:
+    FrameTimeHistogram(size_t _windowSize = 600)
+    {
+        m_window.assign(_windowSize, 0);
+    }
+
+    static int BucketIndex(uint32_t _microseconds)
+    {
+        uint32_t value = std::min(_microseconds, MAX_MICROSECONDS);
+
+        if (value < 2 * SUB_BUCKET_COUNT)
+            return (int)value;
+
+        int msb = std::bit_width(value) - 1;
+        int shift = msb - SUB_BUCKET_BITS;
+        return (shift + 1) * SUB_BUCKET_COUNT + (int)((value >> shift) - SUB_BUCKET_COUNT);
+    }
+
+    static uint32_t BucketLower(int _index)
+    {
+        if (_index < 2 * SUB_BUCKET_COUNT)
+            return (uint32_t)_index;
+
+        int shift = _index / SUB_BUCKET_COUNT - 1;
+        return (uint32_t)((_index % SUB_BUCKET_COUNT) + SUB_BUCKET_COUNT) << shift;
+    }
+
+    // last microsecond value that lands in the bucket
+    static uint32_t BucketUpper(int _index)
+    {
+        if (_index + 1 >= BUCKET_COUNT)
+            return MAX_MICROSECONDS;
+        return BucketLower(_index + 1) - 1;
+    }
+
+    void Record(float _seconds)
+    {
+        uint32_t microseconds = (uint32_t)std::clamp(_seconds * 1000000.0f, 0.0f, (float)MAX_MICROSECONDS);
+        int index = BucketIndex(microseconds);
+
+        m_totalCounts[index]++;
+        m_totalSamples++;
+        m_totalMax = std::max(m_totalMax, microseconds);
+
+        if (m_window.empty())
+            return;
+
+        if (m_windowFilled == m_window.size())
+            m_windowCounts[m_window[m_windowNext]]--;
+        else
+            m_windowFilled++;
+
+        m_window[m_windowNext] = (uint16_t)index;
+        m_windowCounts[index]++;
+        m_windowNext = (m_windowNext + 1) % m_window.size();
+    }
+
+    // rolling window percentile in milliseconds, reported as the top of its bucket
+    float WindowPercentile(float _percentile) const
+    {
+        return Percentile(m_windowCounts, m_windowFilled, _percentile) / 1000.0f;
+    }
+
+    float WindowMax() const
+    {
+        return WindowPercentile(100.0f);
+    }
+
+    float TotalPercentile(float _percentile) const
+    {
+        return Percentile(m_totalCounts, m_totalSamples, _percentile) / 1000.0f;
+    }
+
+    float TotalMax() const
+    {
+        return m_totalMax / 1000.0f;
+    }
+
+    uint64_t TotalSamples() const
+    {
+        return m_totalSamples;
+    }
+
+    uint32_t TotalCount(int _index) const
+    {
+        return m_totalCounts[_index];
+    }
+};
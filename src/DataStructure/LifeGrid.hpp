@@ -0,0 +1,274 @@
+#pragma once
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "../Threading/WorkerPool.hpp"
+
+// Headless Game of Life boards shared by GameOfLifeSystem and the life_bench target.
+// Every board wraps around its edges the same way the rules loop always has.
+namespace LifeGrid
+{
+    struct Board
+    {
+        int width = 0;
+        int height = 0;
+        std::vector<uint8_t> cells = {};
+        std::vector<uint8_t> next = {};
+    };
+
+    inline void Init(Board &_board, int _width, int _height)
+    {
+        _board.width = _width;
+        _board.height = _height;
+        _board.cells.assign((size_t)_width * _height, 0);
+        _board.next.assign((size_t)_width * _height, 0);
+    }
+
+    inline void Clear(Board &_board)
+    {
+        std::fill(_board.cells.begin(), _board.cells.end(), 0);
+    }
+
+    inline bool Get(const Board &_board, int _x, int _y)
+    {
+        return _board.cells[(size_t)_y * _board.width + _x];
+    }
+
+    inline void Set(Board &_board, int _x, int _y, bool _alive)
+    {
+        _board.cells[(size_t)_y * _board.width + _x] = _alive;
+    }
+
+    inline size_t Population(const Board &_board)
+    {
+        size_t count = 0;
+        for (uint8_t cell : _board.cells)
+            count += cell;
+        return count;
+    }
+
+    // one cell at a time with the wrap worked out per cell, exactly like the original rules loop
+    inline void StepReference(Board &_board)
+    {
+        int sizeX = _board.width;
+        int sizeY = _board.height;
+
+        for (int yIndex = 0; yIndex < sizeY; yIndex++)
+        {
+            for (int xIndex = 0; xIndex < sizeX; xIndex++)
+            {
+                int right = ((xIndex + 1) >= sizeX) ? 0 : xIndex + 1;
+                int left = ((xIndex - 1) < 0) ? sizeX - 1 : xIndex - 1;
+                int up = ((yIndex + 1) >= sizeY) ? 0 : yIndex + 1;
+                int down = ((yIndex - 1) < 0) ? sizeY - 1 : yIndex - 1;
+
+                int count = Get(_board, right, up) + Get(_board, right, yIndex) + Get(_board, right, down) +
+                            Get(_board, xIndex, up) + Get(_board, xIndex, down) +
+                            Get(_board, left, up) + Get(_board, left, yIndex) + Get(_board, left, down);
+
+                bool alive = Get(_board, xIndex, yIndex);
+                _board.next[(size_t)yIndex * sizeX + xIndex] = (count == 3) || (count == 2 && alive);
+            }
+        }
+
+        _board.cells.swap(_board.next);
+    }
+
+    // writes rows [_firstRow, _lastRow) of next from cells, only the edge columns pay for the wrap
+    inline void StepRows(Board &_board, int _firstRow, int _lastRow)
+    {
+        const int w = _board.width;
+        const int h = _board.height;
+
+        for (int y = _firstRow; y < _lastRow; y++)
+        {
+            const uint8_t *up = &_board.cells[(size_t)((y + h - 1) % h) * w];
+            const uint8_t *row = &_board.cells[(size_t)y * w];
+            const uint8_t *down = &_board.cells[(size_t)((y + 1) % h) * w];
+            uint8_t *out = &_board.next[(size_t)y * w];
+
+            for (int x = 0; x < w; x++)
+            {
+                int l = (x == 0) ? w - 1 : x - 1;
+                int r = (x == w - 1) ? 0 : x + 1;
+
+                int count = up[l] + up[x] + up[r] +
+                            row[l] + row[r] +
+                            down[l] + down[x] + down[r];
+
+                out[x] = (count == 3) | ((count == 2) & row[x]);
+            }
+        }
+    }
+
+    inline void Step(Board &_board)
+    {
+        StepRows(_board, 0, _board.height);
+        _board.cells.swap(_board.next);
+    }
+
+    // one band of rows handed to a worker
+    struct Band
+    {
+        const std::function<void(int, int)> *rows = nullptr;
+        int first = 0;
+        int last = 0;
+    };
+
+    static int BandThread(void *_band)
+    {
+        Band *band = static_cast<Band *>(_band);
+        (*band->rows)(band->first, band->last);
+        return 0;
+    }
+
+    // persistent threads for the banded loops, the caller works one band itself
+    struct Workers
+    {
+        WorkerPool pool;
+        std::vector<Band> bands = {};
+    };
+
+    // _threadCount bands in total, so one thread less is started
+    inline void StartWorkers(Workers &_workers, unsigned int _threadCount)
+    {
+        _workers.pool.Start((_threadCount > 1) ? _threadCount - 1 : 0, "LifeGrid");
+        _workers.bands.resize(_workers.pool.Size() + 1);
+        for (unsigned int i = 0; i < _workers.pool.Size(); i++)
+            _workers.pool.SetArgument(i, &_workers.bands[i]);
+    }
+
+    // splits rows [0, _height) into one horizontal band per thread and waits for all of them
+    inline void ForEachBand(Workers &_workers, int _height, const std::function<void(int, int)> &_rows)
+    {
+        size_t bandCount = _workers.bands.size();
+        if (bandCount <= 1 || _height < (int)bandCount)
+        {
+            _rows(0, _height);
+            return;
+        }
+
+        for (size_t b = 0; b < bandCount; b++)
+        {
+            _workers.bands[b].rows = &_rows;
+            _workers.bands[b].first = (int)(((size_t)_height * b) / bandCount);
+            _workers.bands[b].last = (int)(((size_t)_height * (b + 1)) / bandCount);
+        }
+
+        _workers.pool.Dispatch(BandThread);
+        BandThread(&_workers.bands.back());
+        _workers.pool.Wait();
+    }
+
+    inline void StepParallel(Board &_board, Workers &_workers)
+    {
+        ForEachBand(_workers, _board.height, [&_board](int _first, int _last) { StepRows(_board, _first, _last); });
+        _board.cells.swap(_board.next);
+    }
+
+    // 64 cells per word, neighbours summed with bit sliced adders
+    // width has to be a multiple of 64
+    struct BitBoard
+    {
+        int width = 0;
+        int height = 0;
+        int wordsPerRow = 0;
+        std::vector<uint64_t> words = {};
+        std::vector<uint64_t> next = {};
+    };
+
+    inline bool Supports(int _width)
+    {
+        return _width > 0 && _width % 64 == 0;
+    }
+
+    inline void Init(BitBoard &_board, int _width, int _height)
+    {
+        _board.width = _width;
+        _board.height = _height;
+        _board.wordsPerRow = _width / 64;
+        _board.words.assign((size_t)_board.wordsPerRow * _height, 0);
+        _board.next.assign((size_t)_board.wordsPerRow * _height, 0);
+    }
+
+    inline void Pack(BitBoard &_bits, const Board &_board)
+    {
+        Init(_bits, _board.width, _board.height);
+
+        for (int y = 0; y < _board.height; y++)
+            for (int x = 0; x < _board.width; x++)
+                if (Get(_board, x, y))
+                    _bits.words[(size_t)y * _bits.wordsPerRow + (x >> 6)] |= (uint64_t)1 << (x & 63);
+    }
+
+    inline void Unpack(Board &_board, const BitBoard &_bits)
+    {
+        Init(_board, _bits.width, _bits.height);
+
+        for (int y = 0; y < _bits.height; y++)
+            for (int x = 0; x < _bits.width; x++)
+                Set(_board, x, y, (_bits.words[(size_t)y * _bits.wordsPerRow + (x >> 6)] >> (x & 63)) & 1);
+    }
+
+    inline size_t Population(const BitBoard &_board)
+    {
+        size_t count = 0;
+        for (uint64_t word : _board.words)
+            count += std::popcount(word);
+        return count;
+    }
+
+    // three bit counter, s2 sticks once the count reaches four
+    inline void AddNeighbor(uint64_t &_s0, uint64_t &_s1, uint64_t &_s2, uint64_t _x)
+    {
+        uint64_t c0 = _s0 & _x;
+        _s0 ^= _x;
+        uint64_t c1 = _s1 & c0;
+        _s1 ^= c0;
+        _s2 |= c1;
+    }
+
+    inline void Step(BitBoard &_board)
+    {
+        const int n = _board.wordsPerRow;
+        const int h = _board.height;
+
+        for (int y = 0; y < h; y++)
+        {
+            const uint64_t *rows[3] = {
+                &_board.words[(size_t)((y + h - 1) % h) * n],
+                &_board.words[(size_t)y * n],
+                &_board.words[(size_t)((y + 1) % h) * n]};
+            uint64_t *out = &_board.next[(size_t)y * n];
+
+            for (int k = 0; k < n; k++)
+            {
+                int kl = (k == 0) ? n - 1 : k - 1;
+                int kr = (k == n - 1) ? 0 : k + 1;
+
+                uint64_t s0 = 0, s1 = 0, s2 = 0;
+
+                for (int r = 0; r < 3; r++)
+                {
+                    uint64_t center = rows[r][k];
+                    // bit x holds cell x-1 and x+1 respectively
+                    uint64_t west = (center << 1) | (rows[r][kl] >> 63);
+                    uint64_t east = (center >> 1) | (rows[r][kr] << 63);
+
+                    AddNeighbor(s0, s1, s2, west);
+                    AddNeighbor(s0, s1, s2, east);
+                    if (r != 1)
+                        AddNeighbor(s0, s1, s2, center);
+                }
+
+                // two neighbours keeps a live cell, three always lives
+                out[k] = ~s2 & s1 & (s0 | rows[1][k]);
+            }
+        }
+
+        _board.words.swap(_board.next);
+    }
+}
@@ -0,0 +1,198 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "LifeGrid.hpp"
+
+// RGBA pixels of a whole Game of Life board, for drawing the board as one texture.
+//
+// Every cell is a square of cellPixels * cellPixels pixels. The image remembers which state each
+// cell was last drawn in, so an update only rewrites the board rows that changed and reports them
+// as dirty for the texture upload. Nothing here touches OpenGL, life_bench and the headless
+// runner check it against a full redraw.
+namespace LifeImage
+{
+    const int MAX_TEXTURE_SIZE = 16384;       // what the desktop GPUs the demos run on allow
+    const size_t MAX_PIXELS = size_t(1) << 24; // 64 MB of RGBA, uploaded whole when the board is created
+
+    struct Image
+    {
+        int width = 0;  // in cells
+        int height = 0; // in cells
+        int cellPixels = 1;
+        uint32_t alive = 0;
+        uint32_t dead = 0;
+        uint32_t border = 0;
+        std::vector<uint32_t> pixels = {};
+        std::vector<uint8_t> shown = {};     // state each cell was last drawn in, 2 before the first draw
+        std::vector<uint8_t> dirtyRows = {}; // per board row, cleared by ClearDirty
+        std::vector<uint32_t> patterns = {}; // one cell wide pixel run per [last pixel row][alive]
+    };
+
+    // bytes in memory order r, g, b, a which is what GL_RGBA with GL_UNSIGNED_BYTE reads
+    inline uint32_t Rgba(uint8_t _r, uint8_t _g, uint8_t _b, uint8_t _a = 255)
+    {
+        uint8_t bytes[4] = {_r, _g, _b, _a};
+        uint32_t pixel;
+        std::memcpy(&pixel, bytes, sizeof(pixel));
+        return pixel;
+    }
+
+    inline int PixelWidth(const Image &_image)
+    {
+        return _image.width * _image.cellPixels;
+    }
+
+    inline int PixelHeight(const Image &_image)
+    {
+        return _image.height * _image.cellPixels;
+    }
+
+    // the largest cell, up to _largest pixels, that keeps the image inside one texture and the pixel budget,
+    // 0 when even one pixel per cell does not fit a texture or the budget
+    inline int FitCellPixels(int _width, int _height, int _largest, int _maxTextureSize, size_t _maxPixels = MAX_PIXELS)
+    {
+        int side = std::max(_width, _height);
+        if (side <= 0 || side > _maxTextureSize || (size_t)_width * _height > _maxPixels)
+            return 0;
+
+        int cellPixels = std::min(_largest, _maxTextureSize / side);
+        while (cellPixels > 1 && (size_t)_width * _height * cellPixels * cellPixels > _maxPixels)
+            cellPixels--;
+        return std::max(cellPixels, 1);
+    }
+
+    inline uint32_t CellPixel(const Image &_image, bool _alive, int _px, int _py)
+    {
+        if (_alive)
+            return _image.alive;
+
+        int last = _image.cellPixels - 1;
+        bool edge = (_px == last) || (_py == last);
+        return (edge && _image.cellPixels >= 4) ? _image.border : _image.dead;
+    }
+
+    // black on white like the cell sprites, cells of 4 pixels and up get the grey outline box.png had
+    inline void Init(Image &_image, int _width, int _height, int _cellPixels)
+    {
+        _image.width = _width;
+        _image.height = _height;
+        _image.cellPixels = std::max(_cellPixels, 1);
+        _image.alive = Rgba(0, 0, 0);
+        _image.dead = Rgba(255, 255, 255);
+        _image.border = (_image.cellPixels >= 4) ? Rgba(160, 160, 160) : _image.dead;
+        _image.pixels.assign((size_t)PixelWidth(_image) * PixelHeight(_image), _image.dead);
+        _image.shown.assign((size_t)_width * _height, 2);
+        _image.dirtyRows.assign(_height, 0);
+
+        const int cp = _image.cellPixels;
+        _image.patterns.resize(4 * cp);
+        for (int lastRow = 0; lastRow < 2; lastRow++)
+            for (int alive = 0; alive < 2; alive++)
+                for (int px = 0; px < cp; px++)
+                    _image.patterns[(lastRow * 2 + alive) * cp + px] = CellPixel(_image, alive, px, lastRow ? cp - 1 : 0);
+    }
+
+    // redraws board rows [_firstRow, _lastRow) that changed since they were last drawn
+    inline void UpdateRows(Image &_image, const LifeGrid::Board &_board, int _firstRow, int _lastRow)
+    {
+        const int w = _image.width;
+        const int cp = _image.cellPixels;
+        const size_t pixelWidth = (size_t)PixelWidth(_image);
+
+        for (int y = _firstRow; y < _lastRow; y++)
+        {
+            const uint8_t *cells = &_board.cells[(size_t)y * w];
+            uint8_t *shown = &_image.shown[(size_t)y * w];
+
+            if (std::memcmp(cells, shown, w) == 0)
+                continue;
+
+            uint32_t *rowPixels = &_image.pixels[(size_t)y * cp * pixelWidth];
+
+            // only the first and the last (border) pixel row are drawn, the ones between are copies of the first
+            for (int py = 0; py < cp; py++)
+            {
+                uint32_t *out = rowPixels + py * pixelWidth;
+
+                if (py > 0 && py < cp - 1)
+                {
+                    std::memcpy(out, rowPixels, pixelWidth * sizeof(uint32_t));
+                    continue;
+                }
+
+                if (cp == 1)
+                {
+                    for (int x = 0; x < w; x++)
+                        out[x] = cells[x] ? _image.alive : _image.dead;
+                    continue;
+                }
+
+                const uint32_t *patterns = &_image.patterns[(py == cp - 1) * 2 * cp];
+                for (int x = 0; x < w; x++)
+                    std::memcpy(out + (size_t)x * cp, patterns + cells[x] * cp, cp * sizeof(uint32_t));
+            }
+
+            std::memcpy(shown, cells, w);
+            _image.dirtyRows[y] = 1;
+        }
+    }
+
+    // the rows in one band per thread like LifeGrid::StepParallel, on the same workers
+    inline void Update(Image &_image, const LifeGrid::Board &_board, LifeGrid::Workers &_workers)
+    {
+        LifeGrid::ForEachBand(_workers, _image.height, [&](int _first, int _last) { UpdateRows(_image, _board, _first, _last); });
+    }
+
+    // calls _span(firstRow, lastRow) for every run of dirty board rows
+    template <typename Span>
+    inline size_t ForEachDirtySpan(const Image &_image, Span _span)
+    {
+        size_t dirty = 0;
+        int y = 0;
+        while (y < _image.height)
+        {
+            if (!_image.dirtyRows[y])
+            {
+                y++;
+                continue;
+            }
+
+            int first = y;
+            while (y < _image.height && _image.dirtyRows[y])
+                y++;
+
+            _span(first, y);
+            dirty += y - first;
+        }
+        return dirty;
+    }
+
+    inline size_t DirtyRowCount(const Image &_image)
+    {
+        return std::count(_image.dirtyRows.begin(), _image.dirtyRows.end(), 1);
+    }
+
+    inline void ClearDirty(Image &_image)
+    {
+        std::fill(_image.dirtyRows.begin(), _image.dirtyRows.end(), 0);
+    }
+
+    // every pixel against a cell by cell redraw of _board
+    inline bool Matches(const Image &_image, const LifeGrid::Board &_board)
+    {
+        const int cp = _image.cellPixels;
+        const size_t pixelWidth = (size_t)PixelWidth(_image);
+
+        for (int y = 0; y < _image.height; y++)
+            for (int x = 0; x < _image.width; x++)
+                for (int py = 0; py < cp; py++)
+                    for (int px = 0; px < cp; px++)
+                        if (_image.pixels[((size_t)y * cp + py) * pixelWidth + (size_t)x * cp + px] !=
+                            CellPixel(_image, LifeGrid::Get(_board, x, y), px, py))
+                            return false;
+        return true;
+    }
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+// Fixed size single producer single consumer ring. Push and Pop never block or allocate,
+// they just fail when the ring is full or empty.
+template <typename T>
+class SpscRing
+{
+private:
+    std::vector<T> m_items = {};
+    size_t m_capacity = 0;
+    alignas(64) std::atomic<size_t> m_head = 0; // next slot to pop
+    alignas(64) std::atomic<size_t> m_tail = 0; // next slot to push
+
+public:
+    void Init(size_t _capacity)
+    {
+        m_capacity = _capacity + 1;
+        m_items.assign(m_capacity, T());
+        m_head = 0;
+        m_tail = 0;
+    }
+
+    bool Push(const T &_item)
+    {
+        size_t tail = m_tail.load(std::memory_order_relaxed);
+        size_t next = (tail + 1) % m_capacity;
+
+        if (next == m_head.load(std::memory_order_acquire))
+            return false;
+
+        m_items[tail] = _item;
+        m_tail.store(next, std::memory_order_release);
+        return true;
+    }
+
+    bool Pop(T &_item)
+    {
+        size_t head = m_head.load(std::memory_order_relaxed);
+
+        if (head == m_tail.load(std::memory_order_acquire))
+            return false;
+
+        _item = m_items[head];
+        m_head.store((head + 1) % m_capacity, std::memory_order_release);
+        return true;
+    }
+};
@@ -0,0 +1,31 @@
+#pragma once
+#include <cstdint>
+
+// Counts the heap allocations of every thread when built with CANIS_DEMOS_COUNT_ALLOCATIONS.
+// The replacement operator new lives in main.cpp since it may only be defined once.
+//
+// Each thread only counts its own allocations, so a check around some work adds up the threads
+// that did the work and is not tripped by whatever unrelated threads allocate at the same time.
+namespace AllocationCounter
+{
+    inline uint64_t &ThreadCounter()
+    {
+        thread_local uint64_t counter = 0;
+        return counter;
+    }
+
+    inline constexpr bool Enabled()
+    {
+#ifdef CANIS_DEMOS_COUNT_ALLOCATIONS
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    // allocations made by the calling thread so far
+    inline uint64_t ThreadCount()
+    {
+        return ThreadCounter();
+    }
+}
@@ -0,0 +1,96 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Per frame timings of one run, written out as a JSON summary at the end of scaling runs.
+// Times are stored in milliseconds.
+class FrameLog
+{
+private:
+    struct Frame
+    {
+        float frame;
+        float update;
+        float draw;
+    };
+
+    std::vector<Frame> m_frames = {};
+
+    static float Percentile(std::vector<float> _values, float _percentile)
+    {
+        if (_values.empty())
+            return 0.0f;
+
+        size_t index = std::min(_values.size() - 1, (size_t)(_values.size() * (_percentile / 100.0f)));
+        std::nth_element(_values.begin(), _values.begin() + index, _values.end());
+        return _values[index];
+    }
+
+    static void WriteStats(FILE *_file, const char *_name, const std::vector<float> &_values)
+    {
+        double total = 0.0;
+        for (float value : _values)
+            total += value;
+
+        std::fprintf(_file, "  \"%s\": {\"mean_ms\": %.4f, \"p50_ms\": %.4f, \"p95_ms\": %.4f, \"p99_ms\": %.4f, \"max_ms\": %.4f},\n",
+                     _name, _values.empty() ? 0.0 : total / _values.size(),
+                     Percentile(_values, 50.0f), Percentile(_values, 95.0f), Percentile(_values, 99.0f),
+                     _values.empty() ? 0.0f : *std::max_element(_values.begin(), _values.end()));
+    }
+
+public:
+    void Reserve(size_t _frames)
+    {
+        m_frames.reserve(_frames);
+    }
+
+    void Record(float _frameMs, float _updateMs, float _drawMs)
+    {
+        m_frames.push_back({_frameMs, _updateMs, _drawMs});
+    }
+
+    size_t Size() const
+    {
+        return m_frames.size();
+    }
+
+    // _header is written as is at the top of the object, e.g. "\"scene\": \"boid_demo\",\n"
+    bool Write(const std::string &_path, const std::string &_header) const
+    {
+        FILE *file = _path.empty() ? stdout : std::fopen(_path.c_str(), "w");
+        if (file == nullptr)
+            return false;
+
+        std::vector<float> frames, updates, draws;
+        for (const Frame &frame : m_frames)
+        {
+            frames.push_back(frame.frame);
+            updates.push_back(frame.update);
+            draws.push_back(frame.draw);
+        }
+
+        std::fprintf(file, "{\n%s  \"frames\": %zu,\n", _header.c_str(), m_frames.size());
+        WriteStats(file, "frame", frames);
+        WriteStats(file, "update", updates);
+        WriteStats(file, "draw", draws);
+
+        std::fprintf(file, "  \"per_frame_columns\": [\"frame_ms\", \"update_ms\", \"draw_ms\"],\n");
+        std::fprintf(file, "  \"per_frame\": [");
+        for (size_t i = 0; i < m_frames.size(); i++)
+            std::fprintf(file, "%s\n    [%.4f, %.4f, %.4f]", i ? "," : "", m_frames[i].frame, m_frames[i].update, m_frames[i].draw);
+        std::fprintf(file, "\n  ]\n}\n");
+
+        if (file != stdout)
+            std::fclose(file);
+        return true;
+    }
+};
+
+inline FrameLog &GetFrameLog()
+{
+    static FrameLog frameLog;
+    return frameLog;
+}
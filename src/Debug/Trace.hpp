@@ -0,0 +1,294 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Opt-in timeline tracing written out as Chrome trace JSON (chrome://tracing or ui.perfetto.dev).
+//
+// Each thread writes complete events into its own preallocated buffer, the only shared write is
+// the buffer count it publishes. A thread gets its buffer in RegisterThread, Configure registers
+// the calling thread and WorkerPool registers its workers as they start, so recording never takes
+// the lock or allocates inside a traced scope. Events from threads that never registered are only
+// counted. Buffers outlive the threads that used them and go back to a free list, so short lived
+// worker threads do not leak one buffer each.
+//
+// Turned on with --trace, --trace-first and --trace-last or the environment variables
+// CANIS_TRACE        output file
+// CANIS_TRACE_FIRST  first frame to record (default 60)
+// CANIS_TRACE_LAST   last frame to record (default first + 120)
+namespace Trace
+{
+    struct Event
+    {
+        const char *name;
+        uint64_t begin; // nanoseconds since Configure
+        uint64_t end;
+        uint64_t threadId;
+    };
+
+    struct ThreadBuffer
+    {
+        std::vector<Event> events = {};
+        std::atomic<size_t> count = 0;
+    };
+
+    struct State
+    {
+        std::atomic<bool> recording = false;
+        bool configured = false;
+        bool written = false;
+        std::atomic<uint64_t> frame = 0;
+        uint64_t firstFrame = 0;
+        uint64_t lastFrame = 0;
+        size_t eventsPerBuffer = 0;
+        std::string path;
+        std::chrono::steady_clock::time_point origin;
+
+        std::mutex lock;
+        std::vector<std::unique_ptr<ThreadBuffer>> buffers = {};
+        std::vector<ThreadBuffer *> freeBuffers = {};
+        std::atomic<uint64_t> unregistered = 0; // events from threads without a buffer
+    };
+
+    inline State &GetState()
+    {
+        static State state;
+        return state;
+    }
+
+    inline uint64_t Now()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - GetState().origin).count();
+    }
+
+    // small sequential ids read better on the timeline than hashed std::thread::id values
+    inline uint64_t ThreadId()
+    {
+        static std::atomic<uint64_t> nextId = 1;
+        thread_local uint64_t id = nextId++;
+        return id;
+    }
+
+    // the calling thread's buffer for as long as it lives, empty until it registers
+    struct LocalBuffer
+    {
+        ThreadBuffer *buffer = nullptr;
+
+        void Acquire()
+        {
+            State &state = GetState();
+            std::lock_guard<std::mutex> guard(state.lock);
+
+            if (!state.freeBuffers.empty())
+            {
+                buffer = state.freeBuffers.back();
+                state.freeBuffers.pop_back();
+                return;
+            }
+
+            state.buffers.push_back(std::make_unique<ThreadBuffer>());
+            buffer = state.buffers.back().get();
+            buffer->events.resize(state.eventsPerBuffer);
+        }
+
+        ~LocalBuffer()
+        {
+            if (buffer == nullptr)
+                return;
+
+            State &state = GetState();
+            std::lock_guard<std::mutex> guard(state.lock);
+            state.freeBuffers.push_back(buffer);
+        }
+    };
+
+    inline LocalBuffer &Local()
+    {
+        thread_local LocalBuffer local;
+        return local;
+    }
+
+    // gives the calling thread its buffer up front, does nothing while tracing is off
+    inline void RegisterThread()
+    {
+        LocalBuffer &local = Local();
+        if (local.buffer == nullptr && GetState().configured)
+            local.Acquire();
+    }
+
+    inline bool Recording()
+    {
+        return GetState().recording.load(std::memory_order_relaxed);
+    }
+
+    inline void Push(const char *_name, uint64_t _begin, uint64_t _end)
+    {
+        ThreadBuffer *buffer = Local().buffer;
+        if (buffer == nullptr)
+        {
+            GetState().unregistered.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        size_t count = buffer->count.load(std::memory_order_relaxed);
+        if (count >= buffer->events.size())
+            return;
+
+        buffer->events[count] = {_name, _begin, _end, ThreadId()};
+        buffer->count.store(count + 1, std::memory_order_release);
+    }
+
+    class Scope
+    {
+    private:
+        const char *m_name;
+        uint64_t m_begin = 0;
+        bool m_active;
+
+    public:
+        Scope(const char *_name) : m_name(_name), m_active(Recording())
+        {
+            if (m_active)
+                m_begin = Now();
+        }
+
+        ~Scope()
+        {
+            if (m_active)
+                Push(m_name, m_begin, Now());
+        }
+    };
+
+    inline bool Write();
+
+    // writes whatever was recorded when the run ends before lastFrame
+    inline void Flush()
+    {
+        State &state = GetState();
+        if (!state.configured || state.written)
+            return;
+
+        state.recording = false;
+        Write();
+    }
+
+    inline void Configure(const std::string &_path, uint64_t _firstFrame, uint64_t _lastFrame, size_t _eventsPerBuffer = 1 << 16)
+    {
+        State &state = GetState();
+
+        // the window can be closed, or the engine can exit, long before lastFrame.
+        // registered after the state exists so it runs before the state is destroyed
+        static bool flushAtExit = (std::atexit([]() { Flush(); }) == 0);
+        (void)flushAtExit;
+
+        state.path = _path;
+        state.firstFrame = _firstFrame;
+        state.lastFrame = _lastFrame;
+        state.eventsPerBuffer = _eventsPerBuffer;
+        state.origin = std::chrono::steady_clock::now();
+        state.frame = 0;
+        state.configured = true;
+        state.written = false;
+        state.recording = (_firstFrame == 0);
+
+        RegisterThread();
+    }
+
+    inline bool ConfigureFromEnvironment()
+    {
+        const char *path = std::getenv("CANIS_TRACE");
+        if (path == nullptr || path[0] == '\0')
+            return false;
+
+        const char *first = std::getenv("CANIS_TRACE_FIRST");
+        const char *last = std::getenv("CANIS_TRACE_LAST");
+
+        uint64_t firstFrame = first ? std::strtoull(first, nullptr, 10) : 60;
+        uint64_t lastFrame = last ? std::strtoull(last, nullptr, 10) : firstFrame + 120;
+
+        Configure(path, firstFrame, lastFrame);
+        return true;
+    }
+
+    inline bool Configured()
+    {
+        return GetState().configured;
+    }
+
+    // keeps the recorded range inside a run of _frames frames, a range starting after the run records it all
+    inline void LimitFrames(uint64_t _frames)
+    {
+        State &state = GetState();
+        if (!state.configured || _frames == 0)
+            return;
+
+        state.lastFrame = std::min(state.lastFrame, _frames);
+        if (state.firstFrame > state.lastFrame)
+        {
+            state.firstFrame = 0;
+            state.recording = true;
+        }
+    }
+
+    inline bool Write()
+    {
+        State &state = GetState();
+        std::lock_guard<std::mutex> guard(state.lock);
+
+        std::ofstream file(state.path, std::ios::trunc);
+        if (!file)
+            return false;
+
+        file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+        bool first = true;
+        for (const std::unique_ptr<ThreadBuffer> &buffer : state.buffers)
+        {
+            size_t count = buffer->count.load(std::memory_order_acquire);
+
+            for (size_t i = 0; i < count; i++)
+            {
+                const Event &event = buffer->events[i];
+                file << (first ? "" : ",\n")
+                     << "{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.threadId
+                     << ",\"ts\":" << event.begin / 1000.0 << ",\"dur\":" << (event.end - event.begin) / 1000.0 << "}";
+                first = false;
+            }
+        }
+
+        file << "\n],\"otherData\":{\"unregistered_thread_events\":" << state.unregistered.load() << "}}\n";
+        state.written = true;
+        return file.good();
+    }
+
+    // call once per frame from the main thread, starts and stops recording on the configured frames
+    inline void NextFrame()
+    {
+        State &state = GetState();
+        if (!state.configured || state.written)
+            return;
+
+        uint64_t frame = ++state.frame;
+
+        if (frame == state.firstFrame)
+            state.recording = true;
+
+        if (frame > state.lastFrame)
+        {
+            state.recording = false;
+            Write();
+        }
+    }
+}
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_SCOPE(name) Trace::Scope TRACE_CONCAT(traceScope, __LINE__)(name)
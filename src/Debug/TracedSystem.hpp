@@ -0,0 +1,73 @@
+#pragma once
+#include <string>
+
+#include <Canis/Scene.hpp>
+#include <Canis/ECS/Systems/RenderHUDSystem.hpp>
+#include <Canis/ECS/Systems/RenderTextSystem.hpp>
+#include <Canis/ECS/Systems/SpriteRenderer2DSystem.hpp>
+#include <Canis/ECS/Systems/SpriteAnimationSystem.hpp>
+#include <Canis/ECS/Systems/CollisionSystem2D.hpp>
+#include <Canis/ECS/Systems/ButtonSystem.hpp>
+
+#include "Trace.hpp"
+
+// Wraps an engine system so its Update shows up on the trace timeline.
+// The decoders below are only registered while tracing so normal runs create the plain systems.
+template <typename T>
+class TracedSystem : public T
+{
+public:
+    static inline const char *traceName = "System";
+
+    void Update(entt::registry &_registry, float _deltaTime)
+    {
+        TRACE_SCOPE(traceName);
+        T::Update(_registry, _deltaTime);
+    }
+};
+
+bool DecodeTracedSystem(const std::string &_name, Canis::Scene *_scene)
+{
+    if (_name == "Canis::ButtonSystem")
+    {
+        TracedSystem<Canis::ButtonSystem>::traceName = "Canis::ButtonSystem";
+        _scene->CreateSystem<TracedSystem<Canis::ButtonSystem>>();
+        return true;
+    }
+    if (_name == "Canis::CollisionSystem2D")
+    {
+        TracedSystem<Canis::CollisionSystem2D>::traceName = "Canis::CollisionSystem2D";
+        _scene->CreateSystem<TracedSystem<Canis::CollisionSystem2D>>();
+        return true;
+    }
+    if (_name == "Canis::SpriteAnimationSystem")
+    {
+        TracedSystem<Canis::SpriteAnimationSystem>::traceName = "Canis::SpriteAnimationSystem";
+        _scene->CreateSystem<TracedSystem<Canis::SpriteAnimationSystem>>();
+        return true;
+    }
+    return false;
+}
+
+bool DecodeTracedRenderSystem(const std::string &_name, Canis::Scene *_scene)
+{
+    if (_name == "Canis::SpriteRenderer2DSystem")
+    {
+        TracedSystem<Canis::SpriteRenderer2DSystem>::traceName = "Canis::SpriteRenderer2DSystem";
+        _scene->CreateRenderSystem<TracedSystem<Canis::SpriteRenderer2DSystem>>();
+        return true;
+    }
+    if (_name == "Canis::RenderHUDSystem")
+    {
+        TracedSystem<Canis::RenderHUDSystem>::traceName = "Canis::RenderHUDSystem";
+        _scene->CreateRenderSystem<TracedSystem<Canis::RenderHUDSystem>>();
+        return true;
+    }
+    if (_name == "Canis::RenderTextSystem")
+    {
+        TracedSystem<Canis::RenderTextSystem>::traceName = "Canis::RenderTextSystem";
+        _scene->CreateRenderSystem<TracedSystem<Canis::RenderTextSystem>>();
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,145 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include "DataStructure/LifeImage.hpp"
+
+// Command line options shared by main, the systems that read them in their constructors and
+// the headless runner.
+struct DemoOptions
+{
+    std::string scene = "boid_demo";
+    int boidCount = -1;   // -1 keeps the system default
+    int threadCount = -1; // -1 keeps the system default
+    uint64_t frames = 0;  // 0 runs until the window closes, headless runs default to 600
+    uint64_t seed = 1;
+    float perceptionRadius = -1.0f; // -1 keeps the boid defaults
+    float farFieldTheta = 0.0f;     // 0 keeps every boid neighbour exact
+    bool headless = false;
+    bool pipelined = false;    // boids step on the workers while the frame is drawn
+    int domainCount = 1;       // headless boids split across this many processes
+    bool parallelSystems = false;   // non conflicting update systems run at the same time
+    bool checkSystemWrites = false; // scheduled systems run one at a time and undeclared writes are logged
+    bool lifeTexture = false; // the Game of Life board is drawn as one streamed texture instead of a sprite per cell
+    int boardWidth = -1;      // -1 sizes the Game of Life board to the window
+    int boardHeight = -1;
+    std::string summaryPath = ""; // empty prints the JSON summary to stdout
+    std::string tracePath = "";
+    uint64_t traceFirstFrame = 60;
+    uint64_t traceLastFrame = 0; // 0 records 120 frames from traceFirstFrame
+    std::string recordPath = ""; // headless boids stream every frame here and read it back
+    std::string restorePath = "";  // the window's boid_demo starts from this snapshot instead of --boids and --seed
+};
+
+inline DemoOptions &GetDemoOptions()
+{
+    static DemoOptions options;
+    return options;
+}
+
+inline void PrintDemoUsage()
+{
+    std::printf("usage: canis_demos [--scene name] [--boids N] [--threads N] [--frames N] [--seed N]\n"
+                "                   [--radius R] [--theta T] [--pipelined]\n"
+                "                   [--parallel-systems] [--check-system-writes] [--life-texture] [--board WxH]\n"
+                "                   [--headless] [--domains N] [--summary file.json] [--trace file.json]\n"
+                "                   [--trace-first N] [--trace-last N]\n"
+                "                   [--record file.btrk] [--restore file.boids]\n");
+}
+
+// returns false when the arguments are not understood
+inline bool ParseDemoOptions(int _argc, char *_argv[], DemoOptions &_options)
+{
+    for (int i = 1; i < _argc; i++)
+    {
+        std::string arg = _argv[i];
+        const char *value = (i + 1 < _argc) ? _argv[i + 1] : nullptr;
+
+        if (arg == "--headless")
+        {
+            _options.headless = true;
+            continue;
+        }
+
+        if (arg == "--pipelined")
+        {
+            _options.pipelined = true;
+            continue;
+        }
+
+        if (arg == "--parallel-systems")
+        {
+            _options.parallelSystems = true;
+            continue;
+        }
+
+        // checking only makes sense for scheduled systems
+        if (arg == "--check-system-writes")
+        {
+            _options.parallelSystems = true;
+            _options.checkSystemWrites = true;
+            continue;
+        }
+
+        if (arg == "--life-texture")
+        {
+            _options.lifeTexture = true;
+            continue;
+        }
+
+        if (value == nullptr)
+            return false;
+
+        if (arg == "--scene")
+            _options.scene = value;
+        else if (arg == "--boids")
+            _options.boidCount = std::atoi(value);
+        else if (arg == "--threads")
+            _options.threadCount = std::atoi(value);
+        else if (arg == "--frames")
+            _options.frames = std::strtoull(value, nullptr, 10);
+        else if (arg == "--seed")
+            _options.seed = std::strtoull(value, nullptr, 10);
+        else if (arg == "--radius")
+            _options.perceptionRadius = std::atof(value);
+        else if (arg == "--theta")
+            _options.farFieldTheta = std::atof(value);
+        else if (arg == "--domains")
+            _options.domainCount = std::atoi(value);
+        else if (arg == "--board")
+        {
+            if (std::sscanf(value, "%dx%d", &_options.boardWidth, &_options.boardHeight) != 2 ||
+                _options.boardWidth <= 0 || _options.boardHeight <= 0)
+                return false;
+        }
+        else if (arg == "--summary")
+            _options.summaryPath = value;
+        else if (arg == "--trace")
+            _options.tracePath = value;
+        else if (arg == "--trace-first")
+            _options.traceFirstFrame = std::strtoull(value, nullptr, 10);
+        else if (arg == "--trace-last")
+            _options.traceLastFrame = std::strtoull(value, nullptr, 10);
+        else if (arg == "--record")
+            _options.recordPath = value;
+        else if (arg == "--restore")
+            _options.restorePath = value;
+        else
+            return false;
+
+        i++;
+    }
+
+    // a drawn board needs at least one texture pixel per cell
+    if (_options.lifeTexture && _options.boardWidth > 0 &&
+        LifeImage::FitCellPixels(_options.boardWidth, _options.boardHeight, 1, LifeImage::MAX_TEXTURE_SIZE) == 0)
+    {
+        std::printf("--board %dx%d is too big to draw, --life-texture boards are at most %d cells a side and %zu cells\n",
+            _options.boardWidth, _options.boardHeight, LifeImage::MAX_TEXTURE_SIZE, LifeImage::MAX_PIXELS);
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,216 @@
+#pragma once
+#include <algorithm>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <Canis/Debug.hpp>
+#include <Canis/SceneManager.hpp>
+#include <Canis/External/entt.hpp>
+
+#include <Canis/ECS/Components/TagComponent.hpp>
+#include <Canis/ECS/Components/Camera2DComponent.hpp>
+#include <Canis/ECS/Components/RectTransformComponent.hpp>
+#include <Canis/ECS/Components/ColorComponent.hpp>
+#include <Canis/ECS/Components/Sprite2DComponent.hpp>
+#include <Canis/ECS/Components/SpriteAnimationComponent.hpp>
+#include <Canis/ECS/Components/CircleColliderComponent.hpp>
+#include <Canis/ECS/Components/TextComponent.hpp>
+#include <Canis/ECS/Components/UIImageComponent.hpp>
+#include <Canis/ECS/Components/UISliderComponent.hpp>
+#include <Canis/ECS/Components/ScriptComponent.hpp>
+
+#include "../Debug/Trace.hpp"
+
+// Keeps every prefab the demos spawn as plain component values after it was loaded once.
+//
+// The first Instantiate of a path goes through SceneManager so the YAML is decoded the usual way,
+// the entities it made are then captured component by component. Every later copy is a range
+// create plus one range insert per component type, no file or parser involved.
+//
+// Only registered component types are captured, every component main.cpp decodes is registered
+// up front and anything else a prefab carries is reported once when it is captured.
+class PrefabCache
+{
+private:
+    struct ComponentTemplate
+    {
+        // stamps the captured value onto every entity in the range
+        std::function<void(entt::registry &, const entt::entity *, const entt::entity *)> insert;
+    };
+
+    struct ComponentType
+    {
+        entt::id_type id;
+        std::function<bool(entt::registry &, entt::entity, ComponentTemplate &)> capture;
+    };
+
+    struct EntityTemplate
+    {
+        std::vector<ComponentTemplate> components = {};
+    };
+
+    struct Prefab
+    {
+        std::vector<EntityTemplate> entities = {};
+    };
+
+    std::vector<ComponentType> m_types = {};
+    std::unordered_map<std::string, Prefab> m_prefabs = {};
+    std::vector<entt::entity> m_spawned = {};
+
+    // every entity that has any component, registered or not, so nothing the prefab made is missed
+    std::unordered_set<entt::entity> CollectEntities(entt::registry &_registry)
+    {
+        std::unordered_set<entt::entity> entities;
+        for (auto [id, storage] : _registry.storage())
+            for (entt::entity entity : storage)
+                entities.insert(entity);
+        return entities;
+    }
+
+    bool Registered(entt::id_type _id)
+    {
+        return std::any_of(m_types.begin(), m_types.end(), [&](const ComponentType &_type) { return _type.id == _id; });
+    }
+
+    // lets SceneManager build one copy, then keeps what it built
+    Prefab &Load(Canis::SceneManager &_sceneManager, entt::registry &_registry, const std::string &_path)
+    {
+        TRACE_SCOPE("PrefabCache::Load");
+
+        std::unordered_set<entt::entity> before = CollectEntities(_registry);
+        _sceneManager.Instantiate(_path);
+        std::unordered_set<entt::entity> after = CollectEntities(_registry);
+
+        std::vector<entt::entity> created;
+        for (entt::entity entity : after)
+            if (before.count(entity) == 0)
+                created.push_back(entity);
+
+        // keep the order the prefab file made them in
+        std::sort(created.begin(), created.end());
+
+        Prefab &prefab = m_prefabs[_path];
+        for (entt::entity entity : created)
+        {
+            EntityTemplate entityTemplate;
+            for (ComponentType &type : m_types)
+            {
+                ComponentTemplate component;
+                if (type.capture(_registry, entity, component))
+                    entityTemplate.components.push_back(std::move(component));
+            }
+
+            for (auto [id, storage] : _registry.storage())
+            {
+                if (storage.contains(entity) && !Registered(id))
+                    Canis::Log("PrefabCache: " + _path + " has a " + std::string(storage.type().name()) +
+                        " that is not registered, copies will not get it");
+            }
+
+            prefab.entities.push_back(std::move(entityTemplate));
+        }
+
+        Canis::Log("PrefabCache: cached " + _path + " (" + std::to_string(prefab.entities.size()) + " entities)");
+        return prefab;
+    }
+
+public:
+    PrefabCache()
+    {
+        // the same list main.cpp hands App::AddDecodeComponent
+        RegisterComponent<Canis::TagComponent>();
+        RegisterComponent<Canis::Camera2DComponent>();
+        RegisterComponent<Canis::RectTransformComponent>();
+        RegisterComponent<Canis::ColorComponent>();
+        RegisterComponent<Canis::TextComponent>();
+        RegisterComponent<Canis::Sprite2DComponent>();
+        RegisterComponent<Canis::UIImageComponent>();
+        RegisterComponent<Canis::UISliderComponent>();
+        RegisterComponent<Canis::SpriteAnimationComponent>();
+        RegisterComponent<Canis::CircleColliderComponent>();
+
+        // every copy gets its own script instance once the scene sees it
+        RegisterComponent<Canis::ScriptComponent>([](Canis::ScriptComponent &_script) {
+            _script.Instance = nullptr;
+        });
+    }
+
+    // _reset runs on the captured value, for anything that must not be shared between copies
+    template <typename T>
+    void RegisterComponent(std::function<void(T &)> _reset = nullptr)
+    {
+        ComponentType type;
+        type.id = entt::type_hash<T>::value();
+
+        type.capture = [_reset](entt::registry &_registry, entt::entity _entity, ComponentTemplate &_component) {
+            if (!_registry.all_of<T>(_entity))
+                return false;
+
+            T value = _registry.get<T>(_entity);
+            if (_reset)
+                _reset(value);
+
+            _component.insert = [value](entt::registry &_target, const entt::entity *_first, const entt::entity *_last) {
+                _target.insert<T>(_first, _last, value);
+            };
+            return true;
+        };
+
+        m_types.push_back(std::move(type));
+    }
+
+    bool Cached(const std::string &_path) const
+    {
+        return m_prefabs.count(_path) > 0;
+    }
+
+    // prefab files changed on disk, the next Instantiate of each path parses it again
+    void Clear()
+    {
+        m_prefabs.clear();
+    }
+
+    // spawns _count copies of the prefab at _path, returns how many copies were made
+    size_t Instantiate(Canis::SceneManager &_sceneManager, entt::registry &_registry, const std::string &_path, size_t _count = 1)
+    {
+        TRACE_SCOPE("PrefabCache::Instantiate");
+
+        if (_count == 0)
+            return 0;
+
+        size_t copies = _count;
+
+        auto it = m_prefabs.find(_path);
+        Prefab *prefab = (it != m_prefabs.end()) ? &it->second : nullptr;
+        if (prefab == nullptr)
+        {
+            // the copy SceneManager made while loading is the first one asked for
+            prefab = &Load(_sceneManager, _registry, _path);
+            copies--;
+        }
+
+        m_spawned.resize(copies);
+        const entt::entity *first = m_spawned.data();
+        const entt::entity *last = m_spawned.data() + copies;
+
+        for (const EntityTemplate &entityTemplate : prefab->entities)
+        {
+            _registry.create(m_spawned.begin(), m_spawned.end());
+
+            for (const ComponentTemplate &component : entityTemplate.components)
+                component.insert(_registry, first, last);
+        }
+
+        return _count;
+    }
+};
+
+inline PrefabCache &GetPrefabCache()
+{
+    static PrefabCache cache;
+    return cache;
+}
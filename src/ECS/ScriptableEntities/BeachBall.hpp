@@ -1,9 +1,13 @@
 #pragma once
+#include <SDL.h>
 #include <string>
 #include <vector>
 #include <Canis/ScriptableEntity.hpp>
 #include <Canis/ECS/Components/RectTransformComponent.hpp>
 
+#include "../PrefabCache.hpp"
+#include "../../Debug/Trace.hpp"
+
 class BeachBall : public Canis::ScriptableEntity
 {
 private:
@@ -14,6 +18,9 @@ private:
     unsigned int m_animIndex = 0;
     std::vector<glm::vec2> m_spawnPoints = {};
 public:
+    std::string prefabPath = "assets/prefebs/test_character.scene";
+    size_t bulkSpawnCount = 1000;
+
     void OnCreate()
     {
         m_countDown = m_timeBetweenAnimation;
@@ -32,6 +39,8 @@ public:
 
     void OnUpdate(float _dt)
     {
+        TRACE_SCOPE("BeachBall::OnUpdate");
+
         auto& rect = GetComponent<Canis::RectTransformComponent>();
 
         float halfSizeX = rect.size.x/2.0f;
@@ -53,9 +62,14 @@ public:
         if (GetInputManager().JustPressedKey(SDLK_r))
             m_speed = 150.0f;
         
+        // D spawns one, shift D spawns bulkSpawnCount in one go
         if (GetInputManager().JustPressedKey(SDLK_d))
         {
-            ((Canis::SceneManager *)m_Entity.scene->sceneManager)->Instantiate("assets/prefebs/test_character.scene");
+            const Uint8 *keystate = SDL_GetKeyboardState(NULL);
+            size_t count = (keystate[SDL_SCANCODE_LSHIFT] || keystate[SDL_SCANCODE_RSHIFT]) ? bulkSpawnCount : 1;
+
+            GetPrefabCache().Instantiate(*(Canis::SceneManager *)m_Entity.scene->sceneManager,
+                m_Entity.scene->entityRegistry, prefabPath, count);
         }
     }
 };
@@ -1,10 +1,17 @@
 #pragma once
+#include <SDL.h>
 #include <SDL_keyboard.h>
 #include <string>
+#include <Canis/SceneManager.hpp>
 #include <Canis/ScriptableEntity.hpp>
 #include <Canis/ECS/Components/RectTransformComponent.hpp>
 #include <Canis/ECS/Components/Camera2DComponent.hpp>
 
+#include "../PrefabCache.hpp"
+#include "../../DemoOptions.hpp"
+#include "../../Debug/Trace.hpp"
+#include "../../Debug/FrameLog.hpp"
+
 class DebugCamera2D : public Canis::ScriptableEntity
 {
 public:
@@ -23,8 +30,34 @@ public:
 
     }
 
+    // ends the run once --frames frames were logged, SceneManager reports seconds
+    void LogFrame(float _dt)
+    {
+        const DemoOptions &options = GetDemoOptions();
+        if (options.frames == 0)
+            return;
+
+        auto *sceneManager = (Canis::SceneManager*)(m_Entity.scene->sceneManager);
+        FrameLog &log = GetFrameLog();
+        log.Record(_dt * 1000.0f, (float)sceneManager->updateTime * 1000.0f, (float)sceneManager->drawTime * 1000.0f);
+
+        if (log.Size() != options.frames)
+            return;
+
+        log.Write(options.summaryPath, "  \"scene\": \"" + options.scene + "\",\n  \"mode\": \"window\",\n");
+
+        SDL_Event quit = {};
+        quit.type = SDL_QUIT;
+        SDL_PushEvent(&quit);
+    }
+
     void OnUpdate(float _dt)
     {
+        // every scene has a debug camera so it is the one that moves the trace and frame log along
+        Trace::NextFrame();
+        TRACE_SCOPE("DebugCamera2D::OnUpdate");
+        LogFrame(_dt);
+
         const float CAMERA_SPEED = 20.0f;
         const float SCALE_SPEED = 0.1f;
         bool moved = false;
@@ -87,6 +120,7 @@ public:
         if (GetInputManager().JustPressedKey(SDLK_F5))
         {
             Canis::Log("Load Scene");
+            GetPrefabCache().Clear();
             ((Canis::SceneManager*)m_Entity.scene->sceneManager)->HotReload();
         }
 
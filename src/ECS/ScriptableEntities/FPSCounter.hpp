@@ -1,26 +1,53 @@
 #pragma once
+#include <cstdio>
+#include <fstream>
 #include <string>
 #include <SDL_keyboard.h>
 #include <Canis/SceneManager.hpp>
 #include <Canis/ScriptableEntity.hpp>
 #include <Canis/ECS/Components/TextComponent.hpp>
+#include <Canis/ECS/Components/ColorComponent.hpp>
+
+#include "../../DataStructure/FrameTimeHistogram.hpp"
+#include "../../Debug/Trace.hpp"
 
 class FPSCounter : public Canis::ScriptableEntity
 {
 private:
     float m_time = 0.0f;
     float m_maxTime = 0.1f;
+
+    // every frame goes in, the text only refreshes every m_maxTime
+    FrameTimeHistogram m_frameTimes;
+    FrameTimeHistogram m_updateTimes;
+    FrameTimeHistogram m_drawTimes;
+
+    float m_hitchThreshold = 1.0f / 30.0f;
+    float m_hitchFlashTime = 1.0f;
+    float m_hitchCountDown = 0.0f;
+    unsigned int m_hitchCount = 0;
+    glm::vec4 m_color = glm::vec4(1.0f);
+
+    std::string Format(float _value)
+    {
+        char buffer[16];
+        std::snprintf(buffer, sizeof(buffer), "%.1f", _value);
+        return buffer;
+    }
+
 public:
+    std::string exportPath = "frame_times.csv";
+
     void OnCreate()
     {
-        
+
     }
 
     void OnReady()
     {
-
+        m_color = GetComponent<Canis::ColorComponent>().color;
     }
-    
+
     void OnDestroy()
     {
 
@@ -28,23 +55,64 @@ public:
 
     void OnUpdate(float _dt)
     {
+        TRACE_SCOPE("FPSCounter::OnUpdate");
+
+        auto *sceneManager = (Canis::SceneManager*)(GetScene().sceneManager);
+
+        // SceneManager reports its update and draw times in seconds
+        m_frameTimes.Record(_dt);
+        m_updateTimes.Record((float)sceneManager->updateTime);
+        m_drawTimes.Record((float)sceneManager->drawTime);
+
+        if (_dt > m_hitchThreshold)
+        {
+            m_hitchCount++;
+            m_hitchCountDown = m_hitchFlashTime;
+            Canis::Log("Hitch " + Format(_dt * 1000.0f) + " ms (UT " + Format((float)sceneManager->updateTime * 1000.0f) +
+                " ms DT " + Format((float)sceneManager->drawTime * 1000.0f) + " ms)");
+        }
+
+        if (GetInputManager().JustPressedKey(SDLK_F9))
+            Export(exportPath);
+
         m_time -= _dt;
+        m_hitchCountDown -= _dt;
 
         if ( m_time > 0.0f )
             return;
-        
+
         m_time = m_maxTime;
 
+        GetComponent<Canis::ColorComponent>().color = (m_hitchCountDown > 0.0f) ? glm::vec4(1.0f, 0.0f, 0.0f, 1.0f) : m_color;
+
         Canis::RectTransformComponent &rectComponent = GetComponent<Canis::RectTransformComponent>();
         Canis::TextComponent &textComponent = GetComponent<Canis::TextComponent>();
         Canis::Text::Set(textComponent, rectComponent, "FPS : " + std::to_string((int)m_Entity.scene->window->fps) +
-                " UT : " + std::to_string((float)((Canis::SceneManager*)(GetScene().sceneManager))->updateTime) +
-                " DT : " + std::to_string((float)((Canis::SceneManager*)(GetScene().sceneManager))->drawTime));
-        
-        //auto *sceneManager = (Canis::SceneManager*)(m_Entity.scene->sceneManager);
-        //Canis::Text::Set(textComponent, rectComponent,
-        //     "UT : " + std::to_string((float)sceneManager->updateTime) +
-        //     " DT : " + std::to_string((float)sceneManager->drawTime));
+                " p50 " + Format(m_frameTimes.WindowPercentile(50.0f)) +
+                " p95 " + Format(m_frameTimes.WindowPercentile(95.0f)) +
+                " p99 " + Format(m_frameTimes.WindowPercentile(99.0f)) +
+                " max " + Format(m_frameTimes.WindowMax()) + " ms" +
+                " UT p99 " + Format(m_updateTimes.WindowPercentile(99.0f)) +
+                " DT p99 " + Format(m_drawTimes.WindowPercentile(99.0f)) +
+                " hitches " + std::to_string(m_hitchCount));
+    }
+
+    // one row per bucket that saw a sample, times in microseconds
+    void Export(const std::string &_path)
+    {
+        std::ofstream file(_path, std::ios::trunc);
+        file << "bucket_min_us,bucket_max_us,frame,update,draw\n";
+
+        for (int i = 0; i < FrameTimeHistogram::BUCKET_COUNT; i++)
+        {
+            if (m_frameTimes.TotalCount(i) == 0 && m_updateTimes.TotalCount(i) == 0 && m_drawTimes.TotalCount(i) == 0)
+                continue;
+
+            file << FrameTimeHistogram::BucketLower(i) << "," << FrameTimeHistogram::BucketUpper(i) << ","
+                 << m_frameTimes.TotalCount(i) << "," << m_updateTimes.TotalCount(i) << "," << m_drawTimes.TotalCount(i) << "\n";
+        }
+
+        Canis::Log("Exported " + std::to_string(m_frameTimes.TotalSamples()) + " frame times to " + _path);
     }
 };
 
@@ -58,4 +126,4 @@ bool DecodeFPSCounter(const std::string &_name, Canis::Entity &_entity)
         return true;
     }
     return false;
-}
\ No newline at end of file
+}
@@ -1,34 +1,89 @@
 #pragma once
+#include <algorithm>
+#include <cmath>
 #include <string>
+#include <thread>
 #include <vector>
+
+#include <GL/glew.h>
+
 #include <Canis/ScriptableEntity.hpp>
 #include <Canis/ECS/Components/RectTransformComponent.hpp>
 #include <Canis/ECS/Components/ColorComponent.hpp>
 #include <Canis/ECS/Components/Sprite2DComponent.hpp>
 
 #include <Canis/AssetManager.hpp>
+#include <Canis/Debug.hpp>
 
 #include "../Components/GameOfLifeComponent.hpp"
+#include "../../DataStructure/LifeGrid.hpp"
+#include "../../DataStructure/LifeImage.hpp"
+#include "../../DemoOptions.hpp"
+#include "../../Math/Random.hpp"
+#include "../../Debug/Trace.hpp"
 
 class GameOfLifeLoader : public Canis::ScriptableEntity
 {
 private:
     unsigned int numberOfRows = 30;
     unsigned int numberOfColumns = 30;
-public:
-    std::vector<std::vector<Canis::Entity>> cells;
-    float cellSize = 12.0f;
+    GLuint m_boardTexture = 0;
+    int m_cellPixels = 0;
 
-    void OnCreate()
+    void SizeBoard(unsigned int _columns, unsigned int _rows)
     {
-        numberOfColumns = GetWindow().GetScreenWidth() / cellSize;
-        numberOfRows = GetWindow().GetScreenHeight() / cellSize;
+        numberOfColumns = _columns;
+        numberOfRows = _rows;
+        LifeGrid::Init(board, numberOfColumns, numberOfRows);
 
-        cells = std::vector(numberOfRows, std::vector<Canis::Entity>(numberOfColumns));
+        displayCellSize = std::min(cellSize, std::min(GetWindow().GetScreenWidth() / (float)numberOfColumns,
+                                                      GetWindow().GetScreenHeight() / (float)numberOfRows));
     }
 
-    void OnReady()
+    // one sprite showing the whole board, GameOfLifeSystem redraws the pixels and this uploads them
+    void CreateBoardTexture()
     {
+        LifeImage::Init(image, numberOfColumns, numberOfRows, m_cellPixels);
+        LifeImage::Update(image, board, workers);
+        LifeImage::ClearDirty(image);
+
+        glGenTextures(1, &m_boardTexture);
+        glBindTexture(GL_TEXTURE_2D, m_boardTexture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, LifeImage::PixelWidth(image), LifeImage::PixelHeight(image), 0,
+            GL_RGBA, GL_UNSIGNED_BYTE, image.pixels.data());
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        Canis::GLTexture texture = {};
+        texture.id = m_boardTexture;
+        texture.width = LifeImage::PixelWidth(image);
+        texture.height = LifeImage::PixelHeight(image);
+
+        // covers the same area the cell sprites did, or the window when the board is bigger
+        Canis::RectTransformComponent transform = {};
+        transform.position = glm::vec2(0.0f);
+        transform.depth = -0.1;
+        transform.size = glm::vec2(displayCellSize * numberOfColumns, displayCellSize * numberOfRows);
+        Canis::ColorComponent color = {};
+        Canis::Sprite2DComponent sprite = {};
+        sprite.uv = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
+        sprite.texture = texture;
+
+        boardSprite = CreateEntity();
+        boardSprite.AddComponent<Canis::RectTransformComponent>(transform);
+        boardSprite.AddComponent<Canis::ColorComponent>(color);
+        boardSprite.AddComponent<Canis::Sprite2DComponent>(sprite);
+    }
+
+    void CreateCellSprites()
+    {
+        // one asset lookup for the whole board instead of one per cell
+        Canis::GLTexture boxTexture = Canis::AssetManager::GetTexture("assets/textures/box.png")->GetTexture();
+
         for(int x = 0; x < numberOfColumns; x++)
         {
             for(int y = 0; y < numberOfRows; y++)
@@ -40,7 +95,7 @@ public:
                 Canis::ColorComponent color = {};
                 Canis::Sprite2DComponent sprite = {};
                 sprite.uv = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
-                sprite.texture = Canis::AssetManager::GetTexture("assets/textures/box.png")->GetTexture();
+                sprite.texture = boxTexture;
 
                 GameOfLifeComponent gameOfLife = {};
                 gameOfLife.currentState = false;
@@ -55,15 +110,107 @@ public:
             }
         }
     }
+
+public:
+    std::vector<std::vector<Canis::Entity>> cells;
+    LifeGrid::Board board;
+    float cellSize = 12.0f;
+
+    // board mode, the cells live only in board and are drawn from image
+    bool textureMode = false;
+    LifeImage::Image image;
+    Canis::Entity boardSprite;
+    unsigned int threadCount = 1;
+    LifeGrid::Workers workers;
+
+    // world units per cell on screen, cellSize unless the board had to shrink to fit the window
+    float displayCellSize = 12.0f;
+
+    void OnCreate()
+    {
+        const DemoOptions &options = GetDemoOptions();
+
+        textureMode = options.lifeTexture;
+        threadCount = (options.threadCount > 0) ? options.threadCount : std::max(std::thread::hardware_concurrency(), 1u);
+
+        unsigned int windowColumns = GetWindow().GetScreenWidth() / cellSize;
+        unsigned int windowRows = GetWindow().GetScreenHeight() / cellSize;
+
+        // boards bigger than the window only make sense drawn as one texture
+        if (textureMode && options.boardWidth > 0)
+            SizeBoard(options.boardWidth, options.boardHeight);
+        else
+            SizeBoard(windowColumns, windowRows);
+
+        if (textureMode)
+        {
+            GLint maxTextureSize = 0;
+            glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTextureSize);
+
+            // a big board is shrunk to fit the window, cells are never drawn with more pixels than they get on screen.
+            // DemoOptions rejects boards too big for any texture, a GPU with smaller textures gets the cell sprites
+            m_cellPixels = LifeImage::FitCellPixels(numberOfColumns, numberOfRows, (int)std::ceil(displayCellSize), maxTextureSize);
+            if (m_cellPixels == 0)
+            {
+                Canis::Log("GameOfLifeLoader: a " + std::to_string(numberOfColumns) + "x" + std::to_string(numberOfRows) +
+                    " board does not fit a " + std::to_string(maxTextureSize) + " texture, drawing a window sized board with cell sprites");
+                textureMode = false;
+                SizeBoard(windowColumns, windowRows);
+            }
+        }
+
+        if (!textureMode)
+        {
+            cells = std::vector(numberOfRows, std::vector<Canis::Entity>(numberOfColumns));
+            return;
+        }
+
+        // only the board is stepped and drawn in bands, the cell sprites stay on the system's thread
+        LifeGrid::StartWorkers(workers, threadCount);
+
+        // nobody clicks a whole big board alive, it starts as the same soup the headless runs use
+        if (options.boardWidth > 0)
+        {
+            Random::State random = Random::Seed(options.seed);
+            for (uint8_t &cell : board.cells)
+                cell = Random::Float(random) < 0.35f;
+        }
+    }
+
+    void OnReady()
+    {
+        if (textureMode)
+            CreateBoardTexture();
+        else
+            CreateCellSprites();
+    }
     
     void OnDestroy()
     {
-
+        if (m_boardTexture != 0)
+            glDeleteTextures(1, &m_boardTexture);
+        m_boardTexture = 0;
     }
 
     void OnUpdate(float _dt)
     {
-        
+        TRACE_SCOPE("GameOfLifeLoader::OnUpdate");
+
+        if (!textureMode || m_boardTexture == 0)
+            return;
+
+        // GL has to be called from the main thread, GameOfLifeSystem may run on a worker
+        const int pixelWidth = LifeImage::PixelWidth(image);
+        const int cellPixels = image.cellPixels;
+
+        glBindTexture(GL_TEXTURE_2D, m_boardTexture);
+        LifeImage::ForEachDirtySpan(image, [&](int _firstRow, int _lastRow) {
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, _firstRow * cellPixels, pixelWidth, (_lastRow - _firstRow) * cellPixels,
+                GL_RGBA, GL_UNSIGNED_BYTE, &image.pixels[(size_t)_firstRow * cellPixels * pixelWidth]);
+        });
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        LifeImage::ClearDirty(image);
     }
 };
 
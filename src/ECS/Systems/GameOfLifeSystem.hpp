@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cmath>
+
 #include <SDL_keyboard.h>
 
 #include <glm/glm.hpp>
@@ -11,6 +13,9 @@
 #include <Canis/ECS/Components/TextComponent.hpp>
 
 #include "../Components/GameOfLifeComponent.hpp"
+#include "../../DataStructure/LifeGrid.hpp"
+#include "../../DataStructure/LifeImage.hpp"
+#include "../../Debug/Trace.hpp"
 
 #include "../ScriptableEntities/GameOfLifeLoader.hpp"
 
@@ -20,6 +25,72 @@ private:
     bool m_runRulesUpdate = false;
     float m_resetTime = 0.25f;
     float m_countDown = 0.0f;
+
+    // toggel running
+    void ToggleRunning()
+    {
+        if (GetInputManager().JustPressedKey(SDLK_SPACE))
+        {
+            m_runRulesUpdate = !m_runRulesUpdate;
+
+            Canis::Entity titleText = GetScene().FindEntityWithTag("TITLE");
+
+            Canis::RectTransformComponent& rect = titleText.GetComponent<Canis::RectTransformComponent>();
+            Canis::TextComponent& text = titleText.GetComponent<Canis::TextComponent>();
+
+            if (m_runRulesUpdate)
+                Canis::Text::Set(text, rect, "Game of Life Demo | Running");
+            else
+                Canis::Text::Set(text, rect, "Game of Life Demo | Paused");
+        }
+    }
+
+    // board mode, clicks and the rules go straight to the board and only changed rows are redrawn
+    void UpdateBoard(GameOfLifeLoader &_loader, float _deltaTime)
+    {
+        LifeGrid::Board &board = _loader.board;
+        bool changed = false;
+
+        bool left = GetInputManager().GetLeftClick();
+        bool right = GetInputManager().GetRightClick();
+        if (left || right)
+        {
+            // the same scale the board quad was drawn at
+            int xIndex = (int)std::floor(GetInputManager().mouse.x / _loader.displayCellSize);
+            int yIndex = (int)std::floor(GetInputManager().mouse.y / _loader.displayCellSize);
+
+            if (xIndex >= 0 && xIndex < board.width && yIndex >= 0 && yIndex < board.height)
+            {
+                LifeGrid::Set(board, xIndex, yIndex, left);
+                changed = true;
+            }
+        }
+
+        if (GetInputManager().JustPressedKey(SDLK_c))
+        {
+            LifeGrid::Clear(board);
+            changed = true;
+        }
+
+        if (m_runRulesUpdate)
+        {
+            m_countDown -= _deltaTime;
+
+            if (m_countDown < 0.0f)
+            {
+                m_countDown = m_resetTime;
+                LifeGrid::StepParallel(board, _loader.workers);
+                changed = true;
+            }
+        }
+
+        if (changed)
+        {
+            TRACE_SCOPE("LifeImage::Update");
+            LifeImage::Update(_loader.image, board, _loader.workers);
+        }
+    }
+
 public:
 
     GameOfLifeSystem() : Canis::System() {
@@ -42,6 +113,8 @@ public:
 
     void Update(entt::registry &_registry, float _deltaTime)
     {
+        TRACE_SCOPE("GameOfLifeSystem::Update");
+
         // get all
         auto view = _registry.view<Canis::RectTransformComponent, Canis::ColorComponent, GameOfLifeComponent>();
 
@@ -51,6 +124,13 @@ public:
         // get the scriptable entity off of it
         GameOfLifeLoader* loader = static_cast<GameOfLifeLoader*>(e.GetComponent<Canis::ScriptComponent>().Instance);
 
+        if (loader->textureMode)
+        {
+            ToggleRunning();
+            UpdateBoard(*loader, _deltaTime);
+            return;
+        }
+
         // on click change state
         for(auto[entity, rectTransform, color, gameOfLife] : view.each())
         {
@@ -83,21 +163,7 @@ public:
             }
         }
 
-        // toggel running
-        if (GetInputManager().JustPressedKey(SDLK_SPACE))
-        {
-            m_runRulesUpdate = !m_runRulesUpdate;
-
-            Canis::Entity titleText = GetScene().FindEntityWithTag("TITLE");
-
-            Canis::RectTransformComponent& rect = titleText.GetComponent<Canis::RectTransformComponent>();
-            Canis::TextComponent& text = titleText.GetComponent<Canis::TextComponent>();
-
-            if (m_runRulesUpdate)
-                Canis::Text::Set(text, rect, "Game of Life Demo | Running");
-            else
-                Canis::Text::Set(text, rect, "Game of Life Demo | Paused");
-        }
+        ToggleRunning();
 
         // rules loop
         if (m_runRulesUpdate)
@@ -108,55 +174,27 @@ public:
             {
                 m_countDown = m_resetTime;
 
+                LifeGrid::Board &board = loader->board;
+
                 for(auto[entity, rectTransform, color, gameOfLife] : view.each())
                 {
                     // find index
                     int xIndex = (static_cast<int>(rectTransform.position.x + loader->cellSize) / loader->cellSize) - 1;
                     int yIndex = (static_cast<int>(rectTransform.position.y + loader->cellSize) / loader->cellSize) - 1;
-                    
-                    int count = 0;
-                    int sizeX = loader->cells[0].size();
-                    int sizeY = loader->cells.size();
-                    
-                    // rap the index around the screen
-                    int right = ((xIndex + 1) >= sizeX) ? 0 : xIndex + 1;
-                    int left = ((xIndex - 1) < 0) ? sizeX - 1 : xIndex - 1;
-                    int up = ((yIndex + 1) >= sizeY) ? 0 : yIndex + 1;
-                    int down = ((yIndex - 1) < 0) ? sizeY - 1 : yIndex - 1;
-
-                    // check neighbors
-                    count += (loader->cells[up][right].GetComponent<GameOfLifeComponent>().currentState == true); // top right
-                    count += (loader->cells[yIndex][right].GetComponent<GameOfLifeComponent>().currentState == true); // right
-                    count += (loader->cells[down][right].GetComponent<GameOfLifeComponent>().currentState == true); // bottom right
-                    count += (loader->cells[up][xIndex].GetComponent<GameOfLifeComponent>().currentState == true); // top center
-                    count += (loader->cells[down][xIndex].GetComponent<GameOfLifeComponent>().currentState == true); // bottom center
-                    count += (loader->cells[up][left].GetComponent<GameOfLifeComponent>().currentState == true); // top left
-                    count += (loader->cells[yIndex][left].GetComponent<GameOfLifeComponent>().currentState == true); // left
-                    count += (loader->cells[down][left].GetComponent<GameOfLifeComponent>().currentState == true); // bottom left
-
-                    // rule one
-                    if (count < 2 && gameOfLife.currentState == true)
-                    {
-                        gameOfLife.nextState = false;
-                        gameOfLife.update = true;
-                    }
 
-                    // rule two
-                    if (count > 3 && gameOfLife.currentState == true)
-                    {
-                        gameOfLife.nextState = false;
-                        gameOfLife.update = true;
-                    }
+                    LifeGrid::Set(board, xIndex, yIndex, gameOfLife.currentState);
+                }
 
-                    // rule three
+                // the rules themselves live in LifeGrid so life_bench measures the same loop
+                LifeGrid::Step(board);
 
+                for(auto[entity, rectTransform, color, gameOfLife] : view.each())
+                {
+                    int xIndex = (static_cast<int>(rectTransform.position.x + loader->cellSize) / loader->cellSize) - 1;
+                    int yIndex = (static_cast<int>(rectTransform.position.y + loader->cellSize) / loader->cellSize) - 1;
 
-                    // rule four
-                    if (count == 3 && gameOfLife.currentState == false)
-                    {
-                        gameOfLife.nextState = true;
-                        gameOfLife.update = true;
-                    }
+                    gameOfLife.nextState = LifeGrid::Get(board, xIndex, yIndex);
+                    gameOfLife.update = (gameOfLife.nextState != gameOfLife.currentState);
                 }
             }
         }
@@ -0,0 +1,470 @@
+#pragma once
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <Canis/Debug.hpp>
+#include <Canis/Scene.hpp>
+#include <Canis/External/entt.hpp>
+#include <Canis/ECS/Systems/System.hpp>
+#include <Canis/ECS/Systems/SpriteAnimationSystem.hpp>
+#include <Canis/ECS/Systems/CollisionSystem2D.hpp>
+#include <Canis/ECS/Systems/ButtonSystem.hpp>
+
+#include <Canis/ECS/Components/RectTransformComponent.hpp>
+#include <Canis/ECS/Components/ColorComponent.hpp>
+#include <Canis/ECS/Components/Sprite2DComponent.hpp>
+#include <Canis/ECS/Components/SpriteAnimationComponent.hpp>
+#include <Canis/ECS/Components/CircleColliderComponent.hpp>
+#include <Canis/ECS/Components/TextComponent.hpp>
+#include <Canis/ECS/Components/TagComponent.hpp>
+#include <Canis/ECS/Components/ScriptComponent.hpp>
+#include <Canis/ECS/Components/Camera2DComponent.hpp>
+
+#include "GameOfLifeSystem.hpp"
+#include "BoidSystem.hpp"
+#include "../Components/BoidComponent.hpp"
+#include "../Components/GameOfLifeComponent.hpp"
+#include "../../DemoOptions.hpp"
+#include "../../Debug/Trace.hpp"
+#include "../../Threading/WorkerPool.hpp"
+
+// The components a system touches, declared by hand next to its decoder below.
+// An exclusive system may touch anything (callbacks, scene wide state) and never runs next to another.
+class SystemAccess
+{
+public:
+    struct ComponentType
+    {
+        entt::id_type id;
+        std::string name;
+        std::function<void(entt::registry &)> assure;
+        std::function<uint64_t(entt::registry &)> checksum;
+    };
+
+    std::vector<ComponentType> reads = {};
+    std::vector<ComponentType> writes = {};
+    bool exclusive = false;
+
+    template <typename... T>
+    SystemAccess &Reads()
+    {
+        (reads.push_back(Type<T>()), ...);
+        return *this;
+    }
+
+    template <typename... T>
+    SystemAccess &Writes()
+    {
+        (writes.push_back(Type<T>()), ...);
+        return *this;
+    }
+
+    SystemAccess &Exclusive()
+    {
+        exclusive = true;
+        return *this;
+    }
+
+    bool Conflicts(const SystemAccess &_other) const
+    {
+        if (exclusive || _other.exclusive)
+            return true;
+
+        return Overlaps(writes, _other.reads) || Overlaps(writes, _other.writes) || Overlaps(reads, _other.writes);
+    }
+
+private:
+    static bool Overlaps(const std::vector<ComponentType> &_a, const std::vector<ComponentType> &_b)
+    {
+        for (const ComponentType &a : _a)
+            for (const ComponentType &b : _b)
+                if (a.id == b.id)
+                    return true;
+        return false;
+    }
+
+    // FNV-1a over the raw bytes of every T, enough to notice that something changed them
+    template <typename T>
+    static ComponentType Type()
+    {
+        ComponentType type;
+        type.id = entt::type_hash<T>::value();
+        type.name = std::string(entt::type_name<T>::value());
+        type.assure = [](entt::registry &_registry) { _registry.storage<T>(); };
+        type.checksum = [](entt::registry &_registry) {
+            uint64_t hash = 1469598103934665603ull;
+            auto &storage = _registry.storage<T>();
+            hash = (hash ^ storage.size()) * 1099511628211ull;
+            for (auto entity : storage)
+            {
+                const uint8_t *bytes = reinterpret_cast<const uint8_t *>(&storage.get(entity));
+                for (size_t i = 0; i < sizeof(T); i++)
+                    hash = (hash ^ bytes[i]) * 1099511628211ull;
+            }
+            return hash;
+        };
+        return type;
+    }
+};
+
+// Runs the scene's update systems as a dependency graph instead of one after another.
+//
+// The scheduler is the only system the scene sees. Every scheduled system is created by it, gets
+// the scene, window and input manager the scene gave the scheduler and is updated from here. A system waits for every
+// earlier system it conflicts with, systems that touch disjoint components run at the same time on
+// the scheduler's workers and the main thread, so an update takes about as long as the longest
+// chain of conflicting systems. The scheduler only takes the cores other worker pools left free.
+//
+// With checkWrites on everything runs one at a time and the registry is checksummed around each
+// system, a change the system did not declare a write for is logged. Values are only hashed for
+// the types some system declared, every other storage is checked for added and removed entities.
+// Reads leave no trace and are not checked.
+class SystemScheduler : public Canis::System
+{
+private:
+    struct Entry
+    {
+        std::string name;
+        Canis::System *system = nullptr;
+        SystemAccess access;
+        std::vector<size_t> dependents = {};
+        size_t dependencies = 0;
+        size_t waiting = 0; // guarded by m_readyLock while the systems run
+    };
+
+    std::vector<Entry *> m_entries = {};
+    std::vector<SystemAccess::ComponentType> m_types = {};
+    std::set<std::pair<size_t, entt::id_type>> m_reported = {};
+
+    WorkerPool m_workers;
+    bool m_workersStarted = false;
+
+    // filled per update
+    entt::registry *m_registry = nullptr;
+    float m_deltaTime = 0.0f;
+    std::mutex m_readyLock;
+    std::condition_variable m_readyChanged;
+    std::vector<size_t> m_ready = {};
+    size_t m_finished = 0; // guarded by m_readyLock
+
+    static inline std::unordered_map<Canis::Scene *, SystemScheduler *> s_schedulers = {};
+    static inline SystemScheduler *s_lastCreated = nullptr;
+
+    // the engine pointers the scene hands a system it creates, taken from the ones it handed the scheduler
+    void ShareEngine(Canis::System &_system)
+    {
+        _system.scene = &GetScene();
+        _system.window = window;
+        _system.inputManager = &GetInputManager();
+    }
+
+    void Build()
+    {
+        for (size_t j = 0; j < m_entries.size(); j++)
+        {
+            m_entries[j]->dependencies = 0;
+            m_entries[j]->dependents.clear();
+        }
+
+        // only earlier systems are waited on, conflicting systems keep the order the scene listed them in
+        for (size_t j = 0; j < m_entries.size(); j++)
+        {
+            for (size_t i = 0; i < j; i++)
+            {
+                if (m_entries[i]->access.Conflicts(m_entries[j]->access))
+                {
+                    m_entries[i]->dependents.push_back(j);
+                    m_entries[j]->dependencies++;
+                }
+            }
+        }
+
+        m_types.clear();
+        for (Entry *entry : m_entries)
+        {
+            for (auto *list : {&entry->access.reads, &entry->access.writes})
+            {
+                for (const SystemAccess::ComponentType &type : *list)
+                {
+                    bool known = false;
+                    for (const SystemAccess::ComponentType &existing : m_types)
+                        known = known || (existing.id == type.id);
+                    if (!known)
+                        m_types.push_back(type);
+                }
+            }
+        }
+
+        m_ready.reserve(m_entries.size());
+    }
+
+    // started on the first update, once every system and script had the chance to start its own
+    // workers, and sized to the cores those leave over so BoidSystem's pool is not oversubscribed
+    void StartWorkers()
+    {
+        m_workersStarted = true;
+
+        unsigned int cores = std::max(std::thread::hardware_concurrency(), 1u);
+        unsigned int busy = std::min(WorkerPool::Running(), cores - 1);
+        unsigned int threads = std::min<unsigned int>(m_entries.size(), cores - busy);
+        if (threads > 1)
+            m_workers.Start(threads - 1, "SystemScheduler");
+    }
+
+    void Run(Entry &_entry)
+    {
+        TRACE_SCOPE(_entry.name.c_str());
+        _entry.system->Update(*m_registry, m_deltaTime);
+    }
+
+    // workers and the main thread all pull ready systems until every system has run, a thread
+    // with nothing ready sleeps until a system finishes so it does not take a core from BoidSystem
+    static int Drain(void *_scheduler)
+    {
+        SystemScheduler *scheduler = static_cast<SystemScheduler *>(_scheduler);
+        size_t count = scheduler->m_entries.size();
+
+        std::unique_lock<std::mutex> lock(scheduler->m_readyLock);
+        while (true)
+        {
+            scheduler->m_readyChanged.wait(lock, [&]() { return !scheduler->m_ready.empty() || scheduler->m_finished == count; });
+            if (scheduler->m_ready.empty())
+                break;
+
+            size_t index = scheduler->m_ready.back();
+            scheduler->m_ready.pop_back();
+
+            lock.unlock();
+            Entry &entry = *scheduler->m_entries[index];
+            scheduler->Run(entry);
+            lock.lock();
+
+            size_t released = 0;
+            for (size_t dependent : entry.dependents)
+            {
+                if (--scheduler->m_entries[dependent]->waiting == 0)
+                {
+                    scheduler->m_ready.push_back(dependent);
+                    released++;
+                }
+            }
+
+            // the last system wakes everyone so they can return
+            if (++scheduler->m_finished == count || released > 1)
+                scheduler->m_readyChanged.notify_all();
+            else if (released == 1)
+                scheduler->m_readyChanged.notify_one();
+        }
+
+        return 0;
+    }
+
+    // which entities every storage holds, enough to notice a system adding or removing any component
+    static uint64_t MembershipChecksum(const entt::sparse_set &_storage)
+    {
+        uint64_t hash = 1469598103934665603ull;
+        hash = (hash ^ _storage.size()) * 1099511628211ull;
+        for (entt::entity entity : _storage)
+            hash = (hash ^ entt::to_integral(entity)) * 1099511628211ull;
+        return hash;
+    }
+
+    // storages of declared types also hash their values
+    void Checksum(std::unordered_map<entt::id_type, uint64_t> &_hashes)
+    {
+        _hashes.clear();
+        for (auto [id, storage] : m_registry->storage())
+            _hashes[id] = MembershipChecksum(storage);
+
+        for (const SystemAccess::ComponentType &type : m_types)
+            _hashes[type.id] ^= type.checksum(*m_registry);
+    }
+
+    void UpdateChecked()
+    {
+        std::unordered_map<entt::id_type, uint64_t> before;
+        std::unordered_map<entt::id_type, uint64_t> after;
+
+        for (size_t e = 0; e < m_entries.size(); e++)
+        {
+            Entry &entry = *m_entries[e];
+
+            Checksum(before);
+            Run(entry);
+
+            if (entry.access.exclusive)
+                continue;
+
+            Checksum(after);
+
+            for (auto [id, storage] : m_registry->storage())
+            {
+                bool declared = false;
+                for (const SystemAccess::ComponentType &write : entry.access.writes)
+                    declared = declared || (write.id == id);
+
+                // a storage the system created counts as changed when it put anything in it
+                auto it = before.find(id);
+                bool changed = (it != before.end()) ? (it->second != after[id]) : !storage.empty();
+                if (declared || !changed)
+                    continue;
+
+                if (m_reported.insert({e, id}).second)
+                    Canis::Log("SystemScheduler: " + entry.name + " changed " + std::string(storage.type().name()) +
+                        " without declaring a write");
+            }
+        }
+    }
+
+public:
+    // checksums the registry around each system, for finding missing write declarations
+    bool checkWrites = false;
+
+    SystemScheduler() : Canis::System()
+    {
+        s_lastCreated = this;
+    }
+
+    ~SystemScheduler()
+    {
+        m_workers.Stop();
+
+        for (auto it = s_schedulers.begin(); it != s_schedulers.end();)
+            it = (it->second == this) ? s_schedulers.erase(it) : std::next(it);
+
+        for (Entry *entry : m_entries)
+        {
+            delete entry->system;
+            delete entry;
+        }
+    }
+
+    // the scheduler of _scene, created at the position of the first scheduled system
+    static SystemScheduler &Get(Canis::Scene *_scene)
+    {
+        auto it = s_schedulers.find(_scene);
+        if (it != s_schedulers.end())
+            return *it->second;
+
+        _scene->CreateSystem<SystemScheduler>();
+        s_lastCreated->checkWrites = GetDemoOptions().checkSystemWrites;
+        s_schedulers[_scene] = s_lastCreated;
+        return *s_lastCreated;
+    }
+
+    template <typename T>
+    void Add(const std::string &_name, const SystemAccess &_access)
+    {
+        Entry *entry = new Entry;
+        entry->name = _name;
+        entry->system = new T();
+        entry->access = _access;
+        m_entries.push_back(entry);
+    }
+
+    void Create()
+    {
+        Build();
+
+        for (Entry *entry : m_entries)
+        {
+            ShareEngine(*entry->system);
+            entry->system->Create();
+        }
+    }
+
+    void Ready()
+    {
+        for (Entry *entry : m_entries)
+        {
+            ShareEngine(*entry->system);
+            entry->system->Ready();
+        }
+    }
+
+    void Update(entt::registry &_registry, float _deltaTime)
+    {
+        TRACE_SCOPE("SystemScheduler::Update");
+
+        m_registry = &_registry;
+        m_deltaTime = _deltaTime;
+
+        // creating a storage changes the registry itself, that must not happen while systems run side by side
+        for (const SystemAccess::ComponentType &type : m_types)
+            type.assure(_registry);
+
+        if (checkWrites)
+        {
+            UpdateChecked();
+            return;
+        }
+
+        if (!m_workersStarted)
+            StartWorkers();
+
+        m_ready.clear();
+        m_finished = 0;
+        for (size_t e = 0; e < m_entries.size(); e++)
+        {
+            m_entries[e]->waiting = m_entries[e]->dependencies;
+            if (m_entries[e]->dependencies == 0)
+                m_ready.push_back(e);
+        }
+
+        for (unsigned int i = 0; i < m_workers.Size(); i++)
+            m_workers.SetArgument(i, this);
+
+        m_workers.Dispatch(Drain);
+        Drain(this);
+        m_workers.Wait();
+    }
+};
+
+// registered ahead of the plain decoders when --parallel-systems is on
+bool DecodeScheduledSystem(const std::string &_name, Canis::Scene *_scene)
+{
+    if (_name == "Canis::ButtonSystem")
+    {
+        // button callbacks can do anything
+        SystemScheduler::Get(_scene).Add<Canis::ButtonSystem>(_name, SystemAccess().Exclusive());
+        return true;
+    }
+    if (_name == "Canis::CollisionSystem2D")
+    {
+        SystemScheduler::Get(_scene).Add<Canis::CollisionSystem2D>(_name, SystemAccess()
+            .Reads<Canis::RectTransformComponent>()
+            .Writes<Canis::CircleColliderComponent>());
+        return true;
+    }
+    if (_name == "Canis::SpriteAnimationSystem")
+    {
+        SystemScheduler::Get(_scene).Add<Canis::SpriteAnimationSystem>(_name, SystemAccess()
+            .Writes<Canis::SpriteAnimationComponent, Canis::Sprite2DComponent>());
+        return true;
+    }
+    if (_name == "GameOfLifeSystem")
+    {
+        // FindEntityWithTag reads the tags, the loader's board and image are changed through its script
+        SystemScheduler::Get(_scene).Add<GameOfLifeSystem>(_name, SystemAccess()
+            .Reads<Canis::TagComponent>()
+            .Writes<Canis::ScriptComponent, Canis::RectTransformComponent, Canis::TextComponent, Canis::ColorComponent, GameOfLifeComponent>());
+        return true;
+    }
+    if (_name == "BoidSystem")
+    {
+        SystemScheduler::Get(_scene).Add<BoidSystem>(_name, SystemAccess()
+            .Reads<Canis::Camera2DComponent>()
+            .Writes<Canis::RectTransformComponent, BoidComponent>());
+        return true;
+    }
+    return false;
+}
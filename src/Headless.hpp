@@ -0,0 +1,348 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include <Canis/Debug.hpp>
+#include <Canis/External/entt.hpp>
+
+#include "DemoOptions.hpp"
+#include "Debug/FrameLog.hpp"
+#include "Debug/Trace.hpp"
+#include "DataStructure/LifeGrid.hpp"
+#include "DataStructure/LifeImage.hpp"
+#include "Math/Random.hpp"
+#include "Simulation/BoidSimulation.hpp"
+#include "Simulation/BoidDomains.hpp"
+
+// Runs a scene's simulation without a window or renderer for scaling sweeps on build servers.
+// Every frame steps with a fixed 1/60 s so runs with the same seed do the same work.
+namespace Headless
+{
+    const float FIXED_DELTA_TIME = 1.0f / 60.0f;
+
+    // the window the demos normally open, used to size the flock and the board
+    const float SCREEN_WIDTH = 1920.0f;
+    const float SCREEN_HEIGHT = 1080.0f;
+
+    inline float Milliseconds(std::chrono::high_resolution_clock::time_point _start, std::chrono::high_resolution_clock::time_point _end)
+    {
+        return std::chrono::duration<float, std::milli>(_end - _start).count();
+    }
+
+    inline void StartBoids(BoidSimulation &_simulation, entt::registry &_registry, const DemoOptions &_options,
+                           unsigned int _threadCount, unsigned int _boidCount)
+    {
+        _simulation.Start(_threadCount, _options.seed);
+
+        if (_options.perceptionRadius > 0.0f)
+            _simulation.SetPerceptionRadius(_options.perceptionRadius);
+        _simulation.farFieldTheta = _options.farFieldTheta;
+        _simulation.pipelined = _options.pipelined;
+
+        glm::vec2 halfScreen = glm::vec2(SCREEN_WIDTH, SCREEN_HEIGHT) / 2.0f;
+        _simulation.SpawnBoids(_registry, _boidCount, -halfScreen, halfScreen, nullptr);
+    }
+
+    // reads a finished recording back and compares its last frame with the flock, as JSON lines for the summary
+    inline std::string RecordingCheck(const std::string &_path, BoidSimulation &_simulation, bool &_ok)
+    {
+        std::vector<glm::vec2> positions;
+        _simulation.GatherPositions(positions);
+
+        BoidTrackReader reader;
+        BoidRecorder::Frame frame;
+        uint64_t framesRead = 0;
+        bool lastMatches = false;
+        float maxError = 0.0f;
+
+        if (reader.Open(_path) && reader.BoidCount() == positions.size())
+        {
+            while (reader.Next(frame))
+                framesRead++;
+
+            // positions are stored in 1/POSITION_SCALE steps, anything further off did not survive the trip
+            if (framesRead > 0 && frame.frame == _simulation.frame)
+            {
+                for (size_t i = 0; i < positions.size(); i++)
+                    maxError = std::max(maxError, glm::distance(positions[i], frame.positions[i]));
+                lastMatches = maxError <= 1.0f / BoidRecorder::POSITION_SCALE;
+            }
+        }
+
+        _ok = (framesRead == _simulation.recorder.written) && lastMatches;
+        return "  \"recording_frames\": " + std::to_string(framesRead) +
+            ",\n  \"recording_dropped\": " + std::to_string(_simulation.recorder.dropped) +
+            ",\n  \"recording_max_error\": " + std::to_string(maxError) +
+            ",\n  \"recording_ok\": " + (_ok ? "true" : "false") + ",\n";
+    }
+
+    inline int RunBoids(const DemoOptions &_options, uint64_t _frames, FrameLog &_log)
+    {
+        unsigned int threadCount = (_options.threadCount > 0) ? _options.threadCount : 32;
+        unsigned int boidCount = (_options.boidCount >= 0) ? _options.boidCount : 10000;
+
+        entt::registry registry;
+        BoidSimulation simulation;
+        StartBoids(simulation, registry, _options, threadCount, boidCount);
+
+        if (!_options.recordPath.empty())
+            simulation.ToggleRecording(_options.recordPath);
+
+        for (uint64_t i = 0; i < _frames; i++)
+        {
+            Trace::NextFrame();
+
+            auto start = std::chrono::high_resolution_clock::now();
+            simulation.Step(registry, FIXED_DELTA_TIME, glm::vec2(0.0f));
+            auto end = std::chrono::high_resolution_clock::now();
+
+            _log.Record(Milliseconds(start, end), Milliseconds(start, end), 0.0f);
+        }
+
+        simulation.Sync(registry);
+
+        std::string recording = "";
+        bool recordingOk = true;
+        if (simulation.recorder.IsRecording())
+        {
+            simulation.ToggleRecording(_options.recordPath);
+            recording = RecordingCheck(_options.recordPath, simulation, recordingOk);
+        }
+
+        return _log.Write(_options.summaryPath,
+            "  \"scene\": \"boid_demo\",\n  \"mode\": \"headless\",\n  \"boids\": " + std::to_string(boidCount) +
+            ",\n  \"threads\": " + std::to_string(threadCount) + ",\n  \"seed\": " + std::to_string(_options.seed) +
+            ",\n  \"radius\": " + std::to_string(simulation.cohesionDistance) + ",\n  \"theta\": " + std::to_string(simulation.farFieldTheta) +
+            ",\n  \"pipelined\": " + (_options.pipelined ? "true" : "false") + ",\n" + recording) && recordingOk ? 0 : 1;
+    }
+
+    // neighbours are summed in a different order across domains and the flock amplifies the rounding
+    // within a few dozen frames, so the split is checked against one process over two frames, long
+    // enough for a frame's migrants to be stepped by their new owner. boids almost on top of each
+    // other can already drift in that time from separation alone, a few of them are tolerated while
+    // a lost or misrouted migrant moves a whole strip edge
+    const uint64_t DOMAIN_CHECK_FRAMES = 2;
+    const float DOMAIN_CHECK_TOLERANCE = 0.01f;
+    const double DOMAIN_CHECK_DRIFTED_FRACTION = 0.0005;
+
+    // root mean square and largest distance between _expected and _actual, and how many are further than _tolerance
+    inline void PositionError(const std::vector<glm::vec2> &_expected, const std::vector<glm::vec2> &_actual, float _tolerance,
+        double &_rms, float &_max, uint64_t &_drifted)
+    {
+        double sumSquared = 0.0;
+        _max = 0.0f;
+        _drifted = 0;
+        for (size_t i = 0; i < _expected.size(); i++)
+        {
+            float error = glm::distance(_expected[i], _actual[i]);
+            sumSquared += (double)error * error;
+            _max = std::max(_max, error);
+            if (error > _tolerance)
+                _drifted++;
+        }
+        _rms = _expected.empty() ? 0.0 : std::sqrt(sumSquared / _expected.size());
+    }
+
+    // the same flock split across processes, checked against one process stepping all of it
+    inline int RunBoidDomains(const DemoOptions &_options, uint64_t _frames, FrameLog &_log)
+    {
+        unsigned int threadCount = (_options.threadCount > 0) ? _options.threadCount : 32;
+        unsigned int boidCount = (_options.boidCount >= 0) ? _options.boidCount : 10000;
+
+        // spawned without starting the workers, nothing but this thread may exist when the domains fork
+        entt::registry registry;
+        BoidSimulation spawner;
+        spawner.random = Random::Seed(_options.seed);
+        if (_options.perceptionRadius > 0.0f)
+            spawner.SetPerceptionRadius(_options.perceptionRadius);
+
+        glm::vec2 halfScreen = glm::vec2(SCREEN_WIDTH, SCREEN_HEIGHT) / 2.0f;
+        spawner.SpawnBoids(registry, boidCount, -halfScreen, halfScreen, nullptr);
+
+        std::vector<glm::vec2> positions;
+        std::vector<glm::vec2> velocities;
+        spawner.GatherPositions(positions);
+        spawner.GatherVelocities(velocities);
+
+        BoidDomains::Settings settings;
+        settings.domainCount = _options.domainCount;
+        settings.frames = _frames;
+        settings.deltaTime = FIXED_DELTA_TIME;
+        settings.minX = -halfScreen.x;
+        settings.maxX = halfScreen.x;
+        settings.cohesionDistance = spawner.cohesionDistance;
+        settings.alignmentDistance = spawner.alignmentDistance;
+        settings.separationDistance = spawner.separationDistance;
+
+        BoidDomains::Result result;
+        auto start = std::chrono::high_resolution_clock::now();
+        bool ok = BoidDomains::Simulate(settings, positions, velocities, result);
+        auto end = std::chrono::high_resolution_clock::now();
+
+        // longer runs repeat the first frames untimed for the check
+        uint64_t checkFrames = std::min(_frames, DOMAIN_CHECK_FRAMES);
+        BoidDomains::Result checkResult;
+        if (ok && checkFrames < _frames)
+        {
+            BoidDomains::Settings checkSettings = settings;
+            checkSettings.frames = checkFrames;
+            ok = BoidDomains::Simulate(checkSettings, positions, velocities, checkResult);
+            result.error = checkResult.error;
+        }
+        const std::vector<glm::vec2> &checkPositions = (checkFrames < _frames) ? checkResult.positions : result.positions;
+
+        if (!ok)
+        {
+            Canis::Log("Boid domains failed: " + result.error);
+            return 1;
+        }
+
+        for (float frameMs : result.frameMs)
+            _log.Record(frameMs, frameMs, 0.0f);
+
+        // one process, same seed and options, the workers only start after the last fork
+        entt::registry referenceRegistry;
+        BoidSimulation reference;
+        StartBoids(reference, referenceRegistry, _options, threadCount, boidCount);
+        reference.pipelined = false;
+
+        std::vector<glm::vec2> expected;
+        double checkRms = 0.0;
+        float checkMaxError = 0.0f;
+        uint64_t checkDrifted = 0;
+        for (uint64_t i = 0; i < _frames; i++)
+        {
+            reference.Step(referenceRegistry, FIXED_DELTA_TIME, glm::vec2(0.0f));
+
+            if (i + 1 == checkFrames)
+            {
+                reference.GatherPositions(expected);
+                PositionError(expected, checkPositions, DOMAIN_CHECK_TOLERANCE, checkRms, checkMaxError, checkDrifted);
+            }
+        }
+
+        reference.GatherPositions(expected);
+        double rms = 0.0;
+        float maxError = 0.0f;
+        uint64_t drifted = 0;
+        PositionError(expected, result.positions, DOMAIN_CHECK_TOLERANCE, rms, maxError, drifted);
+
+        bool checkOk = checkDrifted <= (uint64_t)(expected.size() * DOMAIN_CHECK_DRIFTED_FRACTION);
+        if (!checkOk)
+            Canis::Log("Boid domains moved " + std::to_string(checkDrifted) + " boids more than " +
+                std::to_string(DOMAIN_CHECK_TOLERANCE) + " away from one process after " + std::to_string(checkFrames) + " frames");
+
+        std::string owned;
+        std::string migrated;
+        for (unsigned int d = 0; d < settings.domainCount; d++)
+        {
+            owned += ((d > 0) ? ", " : "") + std::to_string(result.owned[d]);
+            migrated += ((d > 0) ? ", " : "") + std::to_string(result.migrated[d]);
+        }
+
+        return _log.Write(_options.summaryPath,
+            "  \"scene\": \"boid_demo\",\n  \"mode\": \"headless_domains\",\n  \"boids\": " + std::to_string(boidCount) +
+            ",\n  \"domains\": " + std::to_string(settings.domainCount) + ",\n  \"seed\": " + std::to_string(_options.seed) +
+            ",\n  \"radius\": " + std::to_string(settings.cohesionDistance) +
+            ",\n  \"wall_ms\": " + std::to_string(Milliseconds(start, end)) +
+            ",\n  \"owned\": [" + owned + "],\n  \"migrated\": [" + migrated + "]" +
+            ",\n  \"check_frames\": " + std::to_string(checkFrames) + ",\n  \"check_max_error\": " + std::to_string(checkMaxError) +
+            ",\n  \"check_drifted\": " + std::to_string(checkDrifted) +
+            ",\n  \"check_ok\": " + (checkOk ? "true" : "false") +
+            ",\n  \"reference_rms_error\": " + std::to_string(rms) + ",\n  \"reference_max_error\": " + std::to_string(maxError) +
+            ",\n  \"reference_drifted\": " + std::to_string(drifted) + ",\n") && checkOk ? 0 : 1;
+    }
+
+    inline int RunGameOfLife(const DemoOptions &_options, uint64_t _frames, FrameLog &_log)
+    {
+        const float CELL_SIZE = 12.0f;
+        unsigned int threadCount = (_options.threadCount > 0) ? _options.threadCount : 1;
+
+        LifeGrid::Board board;
+        if (_options.boardWidth > 0)
+            LifeGrid::Init(board, _options.boardWidth, _options.boardHeight);
+        else
+            LifeGrid::Init(board, SCREEN_WIDTH / CELL_SIZE, SCREEN_HEIGHT / CELL_SIZE);
+
+        Random::State random = Random::Seed(_options.seed);
+        for (uint8_t &cell : board.cells)
+            cell = Random::Float(random) < 0.35f;
+
+        LifeGrid::Workers workers;
+        LifeGrid::StartWorkers(workers, threadCount);
+
+        // --life-texture also builds the board texture's pixels every step, timed as the draw
+        LifeImage::Image image;
+        size_t dirtyRows = 0;
+        if (_options.lifeTexture)
+        {
+            int cellPixels = LifeImage::FitCellPixels(board.width, board.height, (int)CELL_SIZE, LifeImage::MAX_TEXTURE_SIZE);
+            if (cellPixels == 0)
+            {
+                Canis::Log("Headless: the board does not fit a " + std::to_string(LifeImage::MAX_TEXTURE_SIZE) + " texture or 16M pixels");
+                return 1;
+            }
+
+            LifeImage::Init(image, board.width, board.height, cellPixels);
+            LifeImage::Update(image, board, workers);
+            LifeImage::ClearDirty(image);
+        }
+
+        for (uint64_t i = 0; i < _frames; i++)
+        {
+            Trace::NextFrame();
+
+            auto start = std::chrono::high_resolution_clock::now();
+            {
+                TRACE_SCOPE("GameOfLifeSystem::Update");
+                LifeGrid::StepParallel(board, workers);
+            }
+            auto stepped = std::chrono::high_resolution_clock::now();
+
+            if (_options.lifeTexture)
+            {
+                TRACE_SCOPE("LifeImage::Update");
+                LifeImage::Update(image, board, workers);
+                dirtyRows += LifeImage::DirtyRowCount(image);
+                LifeImage::ClearDirty(image);
+            }
+            auto end = std::chrono::high_resolution_clock::now();
+
+            _log.Record(Milliseconds(start, end), Milliseconds(start, stepped), Milliseconds(stepped, end));
+        }
+
+        std::string texture = "";
+        if (_options.lifeTexture)
+            texture = "  \"cell_pixels\": " + std::to_string(image.cellPixels) +
+                ",\n  \"dirty_rows_per_frame\": " + std::to_string(_frames ? (double)dirtyRows / _frames : 0.0) +
+                ",\n  \"image_matches\": " + (LifeImage::Matches(image, board) ? "true" : "false") + ",\n";
+
+        return _log.Write(_options.summaryPath,
+            "  \"scene\": \"game_of_life\",\n  \"mode\": \"headless\",\n  \"board\": [" + std::to_string(board.width) + ", " +
+            std::to_string(board.height) + "],\n  \"threads\": " + std::to_string(threadCount) +
+            ",\n  \"population\": " + std::to_string(LifeGrid::Population(board)) + ",\n" + texture) ? 0 : 1;
+    }
+
+    inline int Run(const DemoOptions &_options)
+    {
+        uint64_t frames = (_options.frames > 0) ? _options.frames : 600;
+
+        FrameLog &log = GetFrameLog();
+        log.Reserve(frames);
+
+        if (_options.scene == "boid_demo" && _options.domainCount > 1)
+            return RunBoidDomains(_options, frames, log);
+
+        if (_options.scene == "boid_demo")
+            return RunBoids(_options, frames, log);
+
+        if (_options.scene == "game_of_life")
+            return RunGameOfLife(_options, frames, log);
+
+        Canis::Log("No headless mode for scene " + _options.scene);
+        return 1;
+    }
+}
@@ -0,0 +1,349 @@
+#pragma once
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <semaphore>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "../DataStructure/SpscRing.hpp"
+
+// Streams per frame boid trajectories to disk without stalling the simulation.
+//
+// The sim thread copies a frame into one of a few preallocated buffers and hands it to a
+// background thread through a lock free ring. When every buffer is still waiting to be
+// written the frame is dropped instead of waiting.
+//
+// File layout
+// [FileHeader] then per frame [FrameHeader][payload]
+// key frame payload   : int32 x, y quantized positions, int16 x, y quantized velocities
+// delta frame payload : int16 x, y position change since the last written frame, int16 x, y velocities
+class BoidRecorder
+{
+public:
+    static constexpr uint32_t MAGIC = 0x4B525442; // "BTRK"
+    static constexpr uint32_t VERSION = 1;
+
+    // 1/64 unit positions and 1/256 unit per frame velocities
+    static constexpr float POSITION_SCALE = 64.0f;
+    static constexpr float VELOCITY_SCALE = 256.0f;
+
+    struct FileHeader
+    {
+        uint32_t magic = MAGIC;
+        uint32_t version = VERSION;
+        uint64_t boidCount = 0;
+        float positionScale = POSITION_SCALE;
+        float velocityScale = VELOCITY_SCALE;
+    };
+
+    enum FrameType : uint32_t
+    {
+        KEY_FRAME = 0,
+        DELTA_FRAME = 1
+    };
+
+    struct FrameHeader
+    {
+        uint64_t frame = 0;
+        uint32_t type = KEY_FRAME;
+        uint32_t payloadBytes = 0;
+    };
+
+    struct Frame
+    {
+        uint64_t frame = 0;
+        std::vector<glm::vec2> positions = {};
+        std::vector<glm::vec2> velocities = {};
+    };
+
+private:
+    std::vector<Frame> m_frames = {};
+    SpscRing<uint32_t> m_free;
+    SpscRing<uint32_t> m_full;
+    uint32_t m_acquired = UINT32_MAX;
+
+    std::thread m_writer;
+    std::atomic<bool> m_running = false;
+    std::counting_semaphore<> m_wake{0}; // released once per submitted frame and on Stop
+    std::ofstream m_file;
+
+    std::vector<int32_t> m_lastPositions = {};
+    std::vector<uint8_t> m_payload = {};
+    uint64_t m_framesSinceKey = 0;
+
+    void WriterLoop()
+    {
+        uint32_t slot;
+
+        while (true)
+        {
+            m_wake.acquire();
+
+            // read before draining so frames submitted ahead of Stop are still written
+            bool running = m_running.load(std::memory_order_acquire);
+
+            while (m_full.Pop(slot))
+            {
+                Encode(m_frames[slot]);
+                m_free.Push(slot);
+                written++;
+            }
+
+            if (!running)
+                break;
+        }
+    }
+
+    template <typename T>
+    void Append(T _value)
+    {
+        const uint8_t *bytes = reinterpret_cast<const uint8_t *>(&_value);
+        m_payload.insert(m_payload.end(), bytes, bytes + sizeof(T));
+    }
+
+    static int16_t QuantizeVelocity(float _value)
+    {
+        return (int16_t)glm::clamp(std::lround(_value * VELOCITY_SCALE), (long)INT16_MIN, (long)INT16_MAX);
+    }
+
+    void Encode(const Frame &_frame)
+    {
+        size_t count = _frame.positions.size();
+        bool key = (m_lastPositions.size() != count * 2) || (m_framesSinceKey >= keyFrameInterval);
+
+        m_payload.clear();
+
+        if (!key)
+        {
+            m_payload.reserve(count * 8);
+
+            for (size_t i = 0; i < count && !key; i++)
+            {
+                for (int axis = 0; axis < 2; axis++)
+                {
+                    int32_t quantized = (int32_t)std::lround(_frame.positions[i][axis] * POSITION_SCALE);
+                    int32_t delta = quantized - m_lastPositions[i * 2 + axis];
+
+                    // something jumped too far for 16 bits, write the whole frame instead
+                    if (delta < INT16_MIN || delta > INT16_MAX)
+                    {
+                        key = true;
+                        break;
+                    }
+
+                    Append<int16_t>((int16_t)delta);
+                    m_lastPositions[i * 2 + axis] = quantized;
+                }
+
+                Append<int16_t>(QuantizeVelocity(_frame.velocities[i].x));
+                Append<int16_t>(QuantizeVelocity(_frame.velocities[i].y));
+            }
+        }
+
+        if (key)
+        {
+            m_payload.clear();
+            m_payload.reserve(count * 12);
+            m_lastPositions.resize(count * 2);
+
+            for (size_t i = 0; i < count; i++)
+            {
+                for (int axis = 0; axis < 2; axis++)
+                {
+                    m_lastPositions[i * 2 + axis] = (int32_t)std::lround(_frame.positions[i][axis] * POSITION_SCALE);
+                    Append<int32_t>(m_lastPositions[i * 2 + axis]);
+                }
+
+                Append<int16_t>(QuantizeVelocity(_frame.velocities[i].x));
+                Append<int16_t>(QuantizeVelocity(_frame.velocities[i].y));
+            }
+
+            m_framesSinceKey = 0;
+        }
+        else
+        {
+            m_framesSinceKey++;
+        }
+
+        FrameHeader header;
+        header.frame = _frame.frame;
+        header.type = key ? KEY_FRAME : DELTA_FRAME;
+        header.payloadBytes = (uint32_t)m_payload.size();
+
+        m_file.write(reinterpret_cast<const char *>(&header), sizeof(FrameHeader));
+        m_file.write(reinterpret_cast<const char *>(m_payload.data()), m_payload.size());
+    }
+
+public:
+    uint64_t keyFrameInterval = 300;
+    std::atomic<uint64_t> written = 0;
+    uint64_t dropped = 0;
+
+    ~BoidRecorder()
+    {
+        Stop();
+    }
+
+    bool IsRecording() const
+    {
+        return m_running.load(std::memory_order_relaxed);
+    }
+
+    bool Start(const std::string &_path, size_t _boidCount, uint32_t _bufferCount = 4)
+    {
+        Stop();
+
+        m_file.open(_path, std::ios::binary | std::ios::trunc);
+        if (!m_file)
+            return false;
+
+        FileHeader header;
+        header.boidCount = _boidCount;
+        m_file.write(reinterpret_cast<const char *>(&header), sizeof(FileHeader));
+
+        m_frames.resize(_bufferCount);
+        for (Frame &frame : m_frames)
+        {
+            frame.positions.resize(_boidCount);
+            frame.velocities.resize(_boidCount);
+        }
+
+        m_free.Init(_bufferCount);
+        m_full.Init(_bufferCount);
+        for (uint32_t i = 0; i < _bufferCount; i++)
+            m_free.Push(i);
+
+        m_acquired = UINT32_MAX;
+        m_lastPositions.clear();
+        m_framesSinceKey = 0;
+        written = 0;
+        dropped = 0;
+
+        m_running = true;
+        m_writer = std::thread(&BoidRecorder::WriterLoop, this);
+        return true;
+    }
+
+    // drains whatever is queued then closes the file
+    void Stop()
+    {
+        if (!m_writer.joinable())
+            return;
+
+        m_running.store(false, std::memory_order_release);
+        m_wake.release();
+        m_writer.join();
+        m_file.close();
+    }
+
+    // sim thread, returns nullptr when every buffer is still queued
+    Frame *Acquire()
+    {
+        if (!IsRecording())
+            return nullptr;
+
+        if (!m_free.Pop(m_acquired))
+        {
+            dropped++;
+            return nullptr;
+        }
+        return &m_frames[m_acquired];
+    }
+
+    // sim thread, hands the acquired frame to the writer
+    void Submit()
+    {
+        m_full.Push(m_acquired);
+        m_acquired = UINT32_MAX;
+        m_wake.release();
+    }
+};
+
+// Reads a BoidRecorder file back one frame at a time, positions and velocities come out
+// dequantized in boid id order.
+class BoidTrackReader
+{
+private:
+    std::ifstream m_file;
+    BoidRecorder::FileHeader m_header = {};
+    std::vector<int32_t> m_positions = {}; // quantized, what delta frames are relative to
+    std::vector<uint8_t> m_payload = {};
+    bool m_haveKey = false;
+
+    template <typename T>
+    static T Read(const uint8_t *&_cursor)
+    {
+        T value;
+        std::memcpy(&value, _cursor, sizeof(T));
+        _cursor += sizeof(T);
+        return value;
+    }
+
+public:
+    bool Open(const std::string &_path)
+    {
+        m_file.open(_path, std::ios::binary);
+        if (!m_file.read(reinterpret_cast<char *>(&m_header), sizeof(BoidRecorder::FileHeader)))
+            return false;
+
+        if (m_header.magic != BoidRecorder::MAGIC || m_header.version != BoidRecorder::VERSION)
+            return false;
+
+        m_positions.assign(m_header.boidCount * 2, 0);
+        m_haveKey = false;
+        return true;
+    }
+
+    uint64_t BoidCount() const
+    {
+        return m_header.boidCount;
+    }
+
+    // false at the end of the file or on a frame that does not fit the header
+    bool Next(BoidRecorder::Frame &_frame)
+    {
+        BoidRecorder::FrameHeader header;
+        if (!m_file.read(reinterpret_cast<char *>(&header), sizeof(BoidRecorder::FrameHeader)))
+            return false;
+
+        size_t count = m_header.boidCount;
+        bool key = (header.type == BoidRecorder::KEY_FRAME);
+        size_t expected = count * (key ? 12 : 8);
+        if (header.payloadBytes != expected || (!key && !m_haveKey))
+            return false;
+
+        m_payload.resize(expected);
+        if (!m_file.read(reinterpret_cast<char *>(m_payload.data()), expected))
+            return false;
+
+        _frame.frame = header.frame;
+        _frame.positions.resize(count);
+        _frame.velocities.resize(count);
+
+        const uint8_t *cursor = m_payload.data();
+        for (size_t i = 0; i < count; i++)
+        {
+            for (int axis = 0; axis < 2; axis++)
+            {
+                if (key)
+                    m_positions[i * 2 + axis] = Read<int32_t>(cursor);
+                else
+                    m_positions[i * 2 + axis] += Read<int16_t>(cursor);
+
+                _frame.positions[i][axis] = m_positions[i * 2 + axis] / m_header.positionScale;
+            }
+
+            _frame.velocities[i].x = Read<int16_t>(cursor) / m_header.velocityScale;
+            _frame.velocities[i].y = Read<int16_t>(cursor) / m_header.velocityScale;
+        }
+
+        m_haveKey = true;
+        return true;
+    }
+};
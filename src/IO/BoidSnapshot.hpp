@@ -0,0 +1,154 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <glm/glm.hpp>
+
+// Binary dump of the whole flock. The file is a fixed header followed by tightly packed arrays,
+// so a load is one mapping and the arrays are used in place.
+//
+// [Header][positions: vec2 * count][velocities: vec2 * count][rotations: float * count]
+namespace BoidSnapshot
+{
+    const uint32_t MAGIC = 0x44494F42; // "BOID"
+    const uint32_t VERSION = 1;
+
+    struct Header
+    {
+        uint32_t magic = MAGIC;
+        uint32_t version = VERSION;
+        uint64_t boidCount = 0;
+        uint64_t frame = 0;
+        uint64_t randomState = 0;
+        uint64_t reserved[2] = {};
+    };
+
+    static_assert(sizeof(Header) % alignof(glm::vec2) == 0, "arrays after the header must stay aligned");
+
+    struct MappedFile
+    {
+        const uint8_t *data = nullptr;
+        size_t size = 0;
+#ifdef _WIN32
+        HANDLE file = INVALID_HANDLE_VALUE;
+        HANDLE mapping = nullptr;
+#endif
+    };
+
+    struct View
+    {
+        const Header *header = nullptr;
+        const glm::vec2 *positions = nullptr;
+        const glm::vec2 *velocities = nullptr;
+        const float *rotations = nullptr;
+    };
+
+    const size_t BYTES_PER_BOID = sizeof(glm::vec2) * 2 + sizeof(float);
+
+    inline size_t FileSize(uint64_t _boidCount)
+    {
+        return sizeof(Header) + _boidCount * BYTES_PER_BOID;
+    }
+
+    inline bool Save(const std::string &_path, const Header &_header,
+                     const glm::vec2 *_positions, const glm::vec2 *_velocities, const float *_rotations)
+    {
+        std::ofstream file(_path, std::ios::binary | std::ios::trunc);
+        if (!file)
+            return false;
+
+        file.write(reinterpret_cast<const char *>(&_header), sizeof(Header));
+        file.write(reinterpret_cast<const char *>(_positions), _header.boidCount * sizeof(glm::vec2));
+        file.write(reinterpret_cast<const char *>(_velocities), _header.boidCount * sizeof(glm::vec2));
+        file.write(reinterpret_cast<const char *>(_rotations), _header.boidCount * sizeof(float));
+
+        return file.good();
+    }
+
+    inline void Unmap(MappedFile &_file)
+    {
+#ifdef _WIN32
+        if (_file.data)
+            UnmapViewOfFile(_file.data);
+        if (_file.mapping)
+            CloseHandle(_file.mapping);
+        if (_file.file != INVALID_HANDLE_VALUE)
+            CloseHandle(_file.file);
+        _file.file = INVALID_HANDLE_VALUE;
+        _file.mapping = nullptr;
+#else
+        if (_file.data)
+            munmap(const_cast<uint8_t *>(_file.data), _file.size);
+#endif
+        _file.data = nullptr;
+        _file.size = 0;
+    }
+
+    inline bool Map(const std::string &_path, MappedFile &_file)
+    {
+#ifdef _WIN32
+        _file.file = CreateFileA(_path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (_file.file == INVALID_HANDLE_VALUE)
+            return false;
+
+        LARGE_INTEGER size;
+        GetFileSizeEx(_file.file, &size);
+        _file.size = (size_t)size.QuadPart;
+
+        _file.mapping = CreateFileMappingA(_file.file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (_file.mapping)
+            _file.data = static_cast<const uint8_t *>(MapViewOfFile(_file.mapping, FILE_MAP_READ, 0, 0, 0));
+#else
+        int fd = open(_path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return false;
+
+        struct stat info;
+        if (fstat(fd, &info) == 0 && info.st_size > 0)
+        {
+            _file.size = (size_t)info.st_size;
+            void *data = mmap(nullptr, _file.size, PROT_READ, MAP_PRIVATE, fd, 0);
+            _file.data = (data == MAP_FAILED) ? nullptr : static_cast<const uint8_t *>(data);
+        }
+        close(fd);
+#endif
+        if (_file.data == nullptr)
+        {
+            Unmap(_file);
+            return false;
+        }
+        return true;
+    }
+
+    // points the view into the mapped file, nothing is copied
+    inline bool Open(const MappedFile &_file, View &_view)
+    {
+        if (_file.size < sizeof(Header))
+            return false;
+
+        const Header *header = reinterpret_cast<const Header *>(_file.data);
+        if (header->magic != MAGIC || header->version != VERSION)
+            return false;
+
+        // checked before FileSize so a corrupt count cannot overflow it
+        if (header->boidCount > (_file.size - sizeof(Header)) / BYTES_PER_BOID)
+            return false;
+
+        _view.header = header;
+        _view.positions = reinterpret_cast<const glm::vec2 *>(_file.data + sizeof(Header));
+        _view.velocities = _view.positions + header->boidCount;
+        _view.rotations = reinterpret_cast<const float *>(_view.velocities + header->boidCount);
+        return true;
+    }
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <cstdint>
+
+// Small splitmix64 generator. The whole state is one integer so it is cheap to give every
+// thread or chunk its own stream and trivial to save and restore.
+namespace Random
+{
+    struct State
+    {
+        uint64_t state = 0x9E3779B97F4A7C15ull;
+    };
+
+    inline uint64_t Next(State &_random)
+    {
+        uint64_t z = (_random.state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    inline State Seed(uint64_t _seed)
+    {
+        State random;
+        random.state = _seed;
+        return random;
+    }
+
+    // independent stream for a chunk of work, the same _seed and _stream always give the same numbers
+    inline State Fork(uint64_t _seed, uint64_t _stream)
+    {
+        State random = Seed(_seed ^ (_stream * 0xD1B54A32D192ED03ull));
+        Next(random);
+        return random;
+    }
+
+    // [0, 1)
+    inline float Float(State &_random)
+    {
+        return (Next(_random) >> 40) * (1.0f / 16777216.0f);
+    }
+
+    inline float Range(State &_random, float _min, float _max)
+    {
+        return _min + (_max - _min) * Float(_random);
+    }
+}
@@ -0,0 +1,456 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#include <glm/glm.hpp>
+
+#include "BoidSimulation.hpp"
+#include "../DataStructure/BoidGrid.hpp"
+
+// Splits the flock across processes for offline runs that do not fit one process.
+//
+// The world is cut into vertical strips, one forked process per strip. Every process steps the
+// boids it owns with the BoidThreadUpdate kernel and sees its neighbours' boids near the shared
+// edges as read only ghosts. Everything the processes exchange goes through one anonymous shared
+// mapping made before the fork, two process shared barriers a frame keep them in step:
+//
+// barrier, read the neighbours' halos and the own inbox, barrier, step, write halos and migrants
+//
+// A boid that leaves a strip is appended to the inbox of the domain whose strip it landed in, however
+// far that is, every domain can append to every inbox. The sender keeps it as a ghost for one more
+// frame since the receiver only puts it in its halo the frame after.
+namespace BoidDomains
+{
+    struct Record
+    {
+        uint32_t id = 0;
+        glm::vec2 position = glm::vec2(0.0f);
+        glm::vec2 velocity = glm::vec2(0.0f);
+    };
+
+    struct Settings
+    {
+        unsigned int domainCount = 2;
+        uint64_t frames = 600;
+        float deltaTime = 1.0f / 60.0f;
+        glm::vec2 seekTarget = glm::vec2(0.0f);
+
+        // the strips split [minX, maxX] evenly, the outer two reach out to infinity
+        float minX = -960.0f;
+        float maxX = 960.0f;
+
+        float cohesionDistance = MAX_COHESION_DISTANCE;
+        float alignmentDistance = MAX_ALIGNMENT_DISTANCE;
+        float separationDistance = MAX_SEPARATION_DISTANCE;
+    };
+
+    struct Result
+    {
+        std::vector<glm::vec2> positions = {}; // spawn order
+        std::vector<glm::vec2> velocities = {};
+        std::vector<uint64_t> owned = {};      // per domain at the end
+        std::vector<uint64_t> migrated = {};   // per domain, boids handed to another domain
+        std::vector<float> frameMs = {};       // wall time of every frame, the slowest domain's
+        std::string error = "";
+    };
+
+    enum Side
+    {
+        LEFT = 0,
+        RIGHT = 1
+    };
+
+#ifdef __linux__
+    // one list of records, capacity records follow the count. Halos have one writer, inboxes are
+    // appended to by every domain through AppendShared
+    struct Exchange
+    {
+        uint64_t count;
+    };
+
+    struct Shared
+    {
+        pthread_barrier_t barrier;
+    };
+
+    // where everything sits in the mapping, only offsets so it means the same in every process
+    struct Layout
+    {
+        size_t capacity = 0;
+        size_t exchangeBytes = 0;
+        size_t exchanges = 0;   // halos [domain][side], then inboxes [domain]
+        size_t positions = 0;
+        size_t velocities = 0;
+        size_t owned = 0;
+        size_t migrated = 0;
+        size_t frameMs = 0;     // [domain][frame]
+        size_t size = 0;
+    };
+
+    inline size_t Align(size_t _offset)
+    {
+        return (_offset + 63) & ~size_t(63);
+    }
+
+    inline Layout BuildLayout(unsigned int _domainCount, size_t _boidCount, uint64_t _frames)
+    {
+        Layout layout;
+        layout.capacity = _boidCount;
+        layout.exchangeBytes = Align(sizeof(Exchange) + sizeof(Record) * _boidCount);
+
+        size_t offset = Align(sizeof(Shared));
+        layout.exchanges = offset;
+        offset += layout.exchangeBytes * _domainCount * 3;
+        layout.positions = offset;
+        offset = Align(offset + sizeof(glm::vec2) * _boidCount);
+        layout.velocities = offset;
+        offset = Align(offset + sizeof(glm::vec2) * _boidCount);
+        layout.owned = offset;
+        offset = Align(offset + sizeof(uint64_t) * _domainCount);
+        layout.migrated = offset;
+        offset = Align(offset + sizeof(uint64_t) * _domainCount);
+        layout.frameMs = offset;
+        offset = Align(offset + sizeof(float) * _frames * _domainCount);
+        layout.size = offset;
+        return layout;
+    }
+
+    template <typename T>
+    inline T *At(uint8_t *_base, size_t _offset)
+    {
+        return reinterpret_cast<T *>(_base + _offset);
+    }
+
+    // what _domain shares with its neighbour on _side
+    inline Exchange *GetHalo(uint8_t *_base, const Layout &_layout, unsigned int _domain, Side _side)
+    {
+        return At<Exchange>(_base, _layout.exchanges + _layout.exchangeBytes * (_domain * 2 + _side));
+    }
+
+    // the boids that moved into _domain's strip during the last step
+    inline Exchange *GetInbox(uint8_t *_base, const Layout &_layout, unsigned int _domainCount, unsigned int _domain)
+    {
+        return At<Exchange>(_base, _layout.exchanges + _layout.exchangeBytes * (_domainCount * 2 + _domain));
+    }
+
+    inline Record *Records(Exchange *_exchange)
+    {
+        return reinterpret_cast<Record *>(_exchange + 1);
+    }
+
+    inline void Append(Exchange *_exchange, const Record &_record)
+    {
+        Records(_exchange)[_exchange->count++] = _record;
+    }
+
+    // for lists several processes write at the same time, the barrier publishes the records
+    inline void AppendShared(Exchange *_exchange, const Record &_record)
+    {
+        uint64_t index = std::atomic_ref<uint64_t>(_exchange->count).fetch_add(1, std::memory_order_relaxed);
+        Records(_exchange)[index] = _record;
+    }
+
+    // left edge of _domain's strip, the strips of the first and the last domain reach out to infinity
+    inline float StripStart(const Settings &_settings, unsigned int _domain)
+    {
+        float width = (_settings.maxX - _settings.minX) / _settings.domainCount;
+        return (_domain == 0) ? -std::numeric_limits<float>::infinity() : _settings.minX + width * _domain;
+    }
+
+    // the domain whose strip holds _x, computed from the same edges every domain tests against
+    inline unsigned int Owner(const Settings &_settings, float _x)
+    {
+        unsigned int owner = 0;
+        while (owner + 1 < _settings.domainCount && _x >= StripStart(_settings, owner + 1))
+            owner++;
+        return owner;
+    }
+
+    inline void RunDomain(uint8_t *_base, const Layout &_layout, const Settings &_settings, unsigned int _domain,
+                          const std::vector<glm::vec2> &_positions, const std::vector<glm::vec2> &_velocities)
+    {
+        Shared *shared = At<Shared>(_base, 0);
+        unsigned int last = _settings.domainCount - 1;
+
+        float low = StripStart(_settings, _domain);
+        float high = (_domain == last) ? std::numeric_limits<float>::infinity() : StripStart(_settings, _domain + 1);
+        float halo = std::max(_settings.cohesionDistance, std::max(_settings.alignmentDistance, _settings.separationDistance));
+
+        std::vector<Record> owned;
+        std::vector<Record> nextOwned;
+        std::vector<Record> ghosts;
+        std::vector<Record> sent; // last frame's migrants, still needed as ghosts for one frame
+
+        for (size_t i = 0; i < _positions.size(); i++)
+            if (_positions[i].x >= low && _positions[i].x < high)
+                owned.push_back(Record{(uint32_t)i, _positions[i], _velocities[i]});
+
+        BoidGrid::GridData grid;
+        BoidGrid::Init(grid, glm::vec2(0.0f), 2560.0f, MAX_COHESION_DISTANCE);
+
+        BoidThreadInfo info;
+        info.boidSimulation = nullptr;
+        info.reg = nullptr;
+        info.boids = nullptr;
+        info.grid = &grid;
+        info.mouseWorldPosition = _settings.seekTarget;
+        info.deltaTime = _settings.deltaTime;
+        info.cohesionDistance = _settings.cohesionDistance;
+        info.alignmentDistance = _settings.alignmentDistance;
+        info.separationDistance = _settings.separationDistance;
+        info.farFieldTheta = 0.0f;
+
+        uint64_t migrated = 0;
+        float *frameMs = At<float>(_base, _layout.frameMs) + _domain * _settings.frames;
+
+        Exchange *halos[2] = {GetHalo(_base, _layout, _domain, LEFT), GetHalo(_base, _layout, _domain, RIGHT)};
+        Exchange *inbox = GetInbox(_base, _layout, _settings.domainCount, _domain);
+
+        // sorts _records into the ones this domain keeps, the halos and the migrants
+        auto publish = [&](const std::vector<Record> &_records) {
+            halos[LEFT]->count = 0;
+            halos[RIGHT]->count = 0;
+
+            nextOwned.clear();
+            sent.clear();
+            for (const Record &record : _records)
+            {
+                if (record.position.x < low || record.position.x >= high)
+                {
+                    AppendShared(GetInbox(_base, _layout, _settings.domainCount, Owner(_settings, record.position.x)), record);
+                    sent.push_back(record);
+                    migrated++;
+                    continue;
+                }
+
+                nextOwned.push_back(record);
+
+                if (_domain > 0 && record.position.x < low + halo)
+                    Append(halos[LEFT], record);
+                if (_domain < last && record.position.x >= high - halo)
+                    Append(halos[RIGHT], record);
+            }
+            owned.swap(nextOwned);
+        };
+
+        // the inbox is emptied before the barrier after which the others append to it again
+        auto receive = [&]() {
+            owned.insert(owned.end(), Records(inbox), Records(inbox) + inbox->count);
+            inbox->count = 0;
+        };
+
+        // the first frame needs the starting halos too
+        publish(owned);
+        std::vector<Record> stepped;
+
+        for (uint64_t frame = 0; frame < _settings.frames; frame++)
+        {
+            auto start = std::chrono::high_resolution_clock::now();
+
+            pthread_barrier_wait(&shared->barrier);
+
+            ghosts.assign(sent.begin(), sent.end());
+
+            // what the left neighbour wrote for its right side and the other way round
+            for (int side = LEFT; side <= RIGHT; side++)
+            {
+                if ((side == LEFT && _domain == 0) || (side == RIGHT && _domain == last))
+                    continue;
+
+                unsigned int neighbour = (side == LEFT) ? _domain - 1 : _domain + 1;
+                Exchange *neighbourHalo = GetHalo(_base, _layout, neighbour, (side == LEFT) ? RIGHT : LEFT);
+                ghosts.insert(ghosts.end(), Records(neighbourHalo), Records(neighbourHalo) + neighbourHalo->count);
+            }
+
+            receive();
+
+            // nobody writes a list before every domain has read it
+            pthread_barrier_wait(&shared->barrier);
+
+            BoidGrid::Clear(grid);
+            BoidGrid::Reserve(grid, owned.size() + ghosts.size());
+            for (const Record &record : owned)
+                BoidGrid::Add(grid, record.position, record.velocity);
+            for (const Record &record : ghosts)
+                BoidGrid::Add(grid, record.position, record.velocity);
+
+            // owned boids are the first slots, ghosts are only read
+            info.startIndex = 0;
+            info.endIndex = owned.size();
+            BoidThreadUpdate(&info);
+
+            stepped.clear();
+            for (size_t i = 0; i < owned.size(); i++)
+                stepped.push_back(Record{owned[i].id, grid.nextPositions[i], grid.nextVelocities[i]});
+            publish(stepped);
+
+            frameMs[frame] = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        }
+
+        // everyone has written their last lists, pick up the migrants still in flight
+        pthread_barrier_wait(&shared->barrier);
+        receive();
+
+        glm::vec2 *positions = At<glm::vec2>(_base, _layout.positions);
+        glm::vec2 *velocities = At<glm::vec2>(_base, _layout.velocities);
+        for (const Record &record : owned)
+        {
+            positions[record.id] = record.position;
+            velocities[record.id] = record.velocity;
+        }
+
+        At<uint64_t>(_base, _layout.owned)[_domain] = owned.size();
+        At<uint64_t>(_base, _layout.migrated)[_domain] = migrated;
+    }
+#endif
+
+    // steps the flock given in spawn order across _settings.domainCount processes,
+    // returns false and sets _result.error when it could not
+    inline bool Simulate(const Settings &_settings, const std::vector<glm::vec2> &_positions,
+                         const std::vector<glm::vec2> &_velocities, Result &_result)
+    {
+#ifdef __linux__
+        float width = (_settings.maxX - _settings.minX) / _settings.domainCount;
+        float halo = std::max(_settings.cohesionDistance, std::max(_settings.alignmentDistance, _settings.separationDistance));
+
+        // halos only ever come from the direct neighbours
+        if (width < 2.0f * halo)
+        {
+            _result.error = "domains are " + std::to_string(width) + " wide, they need to be at least " + std::to_string(2.0f * halo);
+            return false;
+        }
+
+        Layout layout = BuildLayout(_settings.domainCount, _positions.size(), _settings.frames);
+
+        // pages are only backed once a domain writes to them
+        void *mapping = mmap(nullptr, layout.size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        if (mapping == MAP_FAILED)
+        {
+            _result.error = "could not map " + std::to_string(layout.size) + " bytes of shared memory";
+            return false;
+        }
+
+        uint8_t *base = static_cast<uint8_t *>(mapping);
+        Shared *shared = At<Shared>(base, 0);
+
+        pthread_barrierattr_t attributes;
+        pthread_barrierattr_init(&attributes);
+        pthread_barrierattr_setpshared(&attributes, PTHREAD_PROCESS_SHARED);
+        pthread_barrier_init(&shared->barrier, &attributes, _settings.domainCount);
+        pthread_barrierattr_destroy(&attributes);
+
+        std::vector<pid_t> children;
+        for (unsigned int domain = 0; domain < _settings.domainCount; domain++)
+        {
+            pid_t pid = fork();
+            if (pid == 0)
+            {
+                // nothing may unwind past this frame, the child has the parent's whole stack
+                try
+                {
+                    RunDomain(base, layout, _settings, domain, _positions, _velocities);
+                }
+                catch (...)
+                {
+                    _exit(1);
+                }
+                _exit(0);
+            }
+
+            if (pid < 0)
+            {
+                // the ones already running would wait on the barrier forever
+                for (pid_t child : children)
+                    kill(child, SIGKILL);
+                for (pid_t child : children)
+                    waitpid(child, nullptr, 0);
+
+                _result.error = "fork failed for domain " + std::to_string(domain);
+                munmap(mapping, layout.size);
+                return false;
+            }
+
+            children.push_back(pid);
+        }
+
+        // reaped in the order they finish, a domain that died leaves the others stuck on the
+        // barrier so they are killed as soon as one exits abnormally
+        bool ok = true;
+        while (!children.empty())
+        {
+            int status = 0;
+            pid_t child = waitpid(-1, &status, 0);
+            if (child < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                ok = false;
+                break;
+            }
+
+            auto it = std::find(children.begin(), children.end(), child);
+            if (it == children.end())
+                continue;
+
+            children.erase(it);
+
+            if (ok && (!WIFEXITED(status) || WEXITSTATUS(status) != 0))
+            {
+                ok = false;
+                for (pid_t other : children)
+                    kill(other, SIGKILL);
+            }
+        }
+
+        if (ok)
+        {
+            size_t count = _positions.size();
+            _result.positions.assign(At<glm::vec2>(base, layout.positions), At<glm::vec2>(base, layout.positions) + count);
+            _result.velocities.assign(At<glm::vec2>(base, layout.velocities), At<glm::vec2>(base, layout.velocities) + count);
+            _result.owned.assign(At<uint64_t>(base, layout.owned), At<uint64_t>(base, layout.owned) + _settings.domainCount);
+            _result.migrated.assign(At<uint64_t>(base, layout.migrated), At<uint64_t>(base, layout.migrated) + _settings.domainCount);
+
+            // a frame is done when the slowest domain is
+            const float *frameMs = At<float>(base, layout.frameMs);
+            _result.frameMs.assign(frameMs, frameMs + _settings.frames);
+            for (unsigned int domain = 1; domain < _settings.domainCount; domain++)
+                for (uint64_t frame = 0; frame < _settings.frames; frame++)
+                    _result.frameMs[frame] = std::max(_result.frameMs[frame], frameMs[domain * _settings.frames + frame]);
+
+            uint64_t total = 0;
+            for (uint64_t owned : _result.owned)
+                total += owned;
+            if (total != count)
+            {
+                _result.error = "domains ended up owning " + std::to_string(total) + " of " + std::to_string(count) + " boids";
+                ok = false;
+            }
+        }
+        else
+        {
+            _result.error = "a domain process failed";
+        }
+
+        pthread_barrier_destroy(&shared->barrier);
+        munmap(mapping, layout.size);
+        return ok;
+#else
+        _result.error = "domain decomposition needs Linux";
+        return false;
+#endif
+    }
+}
@@ -0,0 +1,735 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+#include <emmintrin.h>
+#include <immintrin.h>
+
+#include <glm/gtc/constants.hpp>
+
+#include <Canis/Debug.hpp>
+#include <Canis/Entity.hpp>
+#include <Canis/AssetManager.hpp>
+#include <Canis/External/entt.hpp>
+
+#include <Canis/ECS/Components/RectTransformComponent.hpp>
+#include <Canis/ECS/Components/ColorComponent.hpp>
+#include <Canis/ECS/Components/Sprite2DComponent.hpp>
+
+#include "../ECS/Components/BoidComponent.hpp"
+#include "../DataStructure/BoidGrid.hpp"
+#include "../Math/Random.hpp"
+#include "../IO/BoidSnapshot.hpp"
+#include "../IO/BoidRecorder.hpp"
+#include "../Debug/Trace.hpp"
+#include "../Debug/AllocationCounter.hpp"
+#include "../Threading/WorkerPool.hpp"
+
+const float MAX_ALIGNMENT_DISTANCE = 15.0f;
+const float MAX_COHESION_DISTANCE = 20.0f;
+const float MAX_SEPARATION_DISTANCE = 10.0f;
+
+const float WANDER_CIRCLE_OFFSET = 50.0f;
+const float WANDER_CIRCLE_RADIUS = 30.0f;
+const float WANDER_ANGLE_DELTA_MAX = 2.0f;
+
+const float USER_BEHAVIOR_WEIGHT = 0.3f;
+const float SEPARATION_WEIGHT = 1.0f;
+const float ALIGNMENT_WEIGHT = 0.3f;
+const float COHESION_WEIGHT = 0.15f;
+
+const float SPEED_MULTIPLIER = 100.0f;
+const float DRAG = 0.95f;
+const float MAXSPEED = 40.0f;
+
+
+// what the renderer needs from one step, indexed by spawn id
+struct BoidFrame
+{
+    std::vector<glm::vec2> positions = {};
+    std::vector<float> rotations = {};
+};
+
+// one per worker, lives as long as the simulation so the crossing list keeps its capacity between frames
+struct BoidThreadInfo
+{
+    void *boidSimulation;
+    entt::registry *reg;
+    std::vector<entt::entity> *boids;
+    BoidGrid::GridData *grid;
+    unsigned int startIndex = 0;
+    unsigned int endIndex = 0;
+    glm::vec2 mouseWorldPosition;
+    float deltaTime;
+
+    float cohesionDistance;
+    float alignmentDistance;
+    float separationDistance;
+    float farFieldTheta;
+
+    // pipelined steps write here instead of the registry, the main thread may be drawing it.
+    // with neither set the step only writes the grid's next state
+    BoidFrame *staged = nullptr;
+    const std::vector<uint32_t> *boidIds = nullptr;
+    const BoidFrame *present = nullptr;
+    const std::vector<entt::entity> *entitiesById = nullptr;
+
+    // slots in this worker's range whose next position left their cell
+    std::vector<int32_t> crossed = {};
+
+    // heap allocations this worker made in its last step or present
+    uint64_t allocations = 0;
+};
+
+// one share of a BoidSimulation::ParallelFor
+struct BoidBatchJob
+{
+    const std::function<void(size_t, size_t)> *body = nullptr;
+    size_t first = 0;
+    size_t last = 0;
+};
+
+static int BoidBatchThread(void *_job)
+{
+    BoidBatchJob *job = static_cast<BoidBatchJob *>(_job);
+    (*job->body)(job->first, job->last);
+    return 0;
+}
+
+static int BoidThreadUpdate(void *_info)
+{
+    TRACE_SCOPE("BoidThreadUpdate");
+    BoidThreadInfo *boidThreadInfo = static_cast<BoidThreadInfo *>(_info);
+    uint64_t allocations = AllocationCounter::ThreadCount();
+    BoidGrid::GridData &grid = *boidThreadInfo->grid;
+    glm::vec2 seekTarget, alignmentTarget, cohesionTarget, separationTarget = glm::vec2(0.0f);
+
+    glm::vec2 alignment = glm::vec2(0.0f);
+    glm::vec2 cohesion = glm::vec2(0.0f);
+    glm::vec2 separation = glm::vec2(0.0f);
+    glm::vec2 acceleration;
+
+    int alignNumNeighbors = 0;
+    int cohNumNeighbors = 0;
+
+    const float cohesionDistance = boidThreadInfo->cohesionDistance;
+    const float alignmentDistance = boidThreadInfo->alignmentDistance;
+    const float separationDistance = boidThreadInfo->separationDistance;
+    const float queryDistance = std::max(cohesionDistance, std::max(alignmentDistance, separationDistance));
+    // a node taken whole has to be inside both far field radii, not just the larger one
+    const float wholeDistance = std::min(cohesionDistance, alignmentDistance);
+
+    boidThreadInfo->crossed.clear(); // does not unalocate the memory
+
+    int max = boidThreadInfo->endIndex;
+    for (int i = boidThreadInfo->startIndex; i < max; i++)
+    {
+        // the grid holds the frame start state, the registry only receives the result
+        glm::vec2 position = grid.positions[i];
+        glm::vec2 velocity = grid.velocities[i];
+        alignment = glm::vec2(0.0f);
+        cohesion = glm::vec2(0.0f);
+        separation = glm::vec2(0.0f);
+        alignNumNeighbors = 0;
+        cohNumNeighbors = 0;
+
+        auto near = [&](int32_t _slot) {
+            if (_slot == i)
+                return;
+
+            glm::vec2 otherPosition = grid.positions[_slot];
+
+            float distance = glm::distance(position, otherPosition);
+
+            if (distance <= cohesionDistance)
+            {
+                cohNumNeighbors++;
+                cohesion += otherPosition;
+            }
+
+            if (distance <= alignmentDistance)
+            {
+                alignNumNeighbors++;
+                alignment += grid.velocities[_slot];
+            }
+
+            if (distance <= separationDistance)
+            {
+                separation += (position - otherPosition);
+            }
+        };
+
+        // a distant node counts as all of its boids sitting at their centroid
+        auto far = [&](const BoidGrid::CellSum &_sum) {
+            float distance = glm::distance(position, _sum.position / (float)_sum.count);
+
+            if (distance <= cohesionDistance)
+            {
+                cohNumNeighbors += _sum.count;
+                cohesion += _sum.position;
+            }
+
+            if (distance <= alignmentDistance)
+            {
+                alignNumNeighbors += _sum.count;
+                alignment += _sum.velocity;
+            }
+        };
+
+        if (boidThreadInfo->farFieldTheta > 0.0f)
+            BoidGrid::ForEachNearFar(grid, position, queryDistance, separationDistance, wholeDistance, boidThreadInfo->farFieldTheta, near, far);
+        else
+            BoidGrid::ForEachNear(grid, position, queryDistance, near);
+
+        // Seek
+        seekTarget = glm::normalize(boidThreadInfo->mouseWorldPosition - position);
+        // Alignment
+        alignmentTarget = (alignment != glm::vec2(0.0f)) ? glm::normalize(alignment / (alignNumNeighbors + 0.0f)) : glm::vec2(0.0f);
+        // Cohesion
+        cohesionTarget = (cohNumNeighbors > 0) ? glm::normalize((cohesion / static_cast<float>(cohNumNeighbors)) - position) : glm::vec2(0.0f);
+        // Separation
+        separationTarget = (separation != glm::vec2(0.0f)) ? glm::normalize(separation) : glm::vec2(0.0f);
+
+        acceleration = ((seekTarget * USER_BEHAVIOR_WEIGHT) +
+                        (alignmentTarget * ALIGNMENT_WEIGHT) +
+                        (cohesionTarget * COHESION_WEIGHT) +
+                        (separationTarget * SEPARATION_WEIGHT)) *
+                        SPEED_MULTIPLIER;
+
+        float rotation = glm::atan(velocity.y, velocity.x);
+
+        // update velocity
+        velocity += (acceleration * boidThreadInfo->deltaTime);
+
+        // clamp velocity to maxSpeed
+        //if (glm::length(velocity) > MAXSPEED)
+        //{
+        //    velocity = glm::normalize(velocity) * MAXSPEED;
+        //}
+
+        // apply drag
+        velocity *= DRAG;
+
+        // update position
+        position += velocity;
+
+        grid.nextPositions[i] = position;
+        grid.nextVelocities[i] = velocity;
+
+        if (boidThreadInfo->staged)
+        {
+            uint32_t id = (*boidThreadInfo->boidIds)[i];
+            boidThreadInfo->staged->positions[id] = position;
+            boidThreadInfo->staged->rotations[id] = rotation;
+        }
+        else if (boidThreadInfo->reg)
+        {
+            auto [rect_transform, boid] = boidThreadInfo->reg->get<Canis::RectTransformComponent, BoidComponent>((*boidThreadInfo->boids)[i]);
+            rect_transform.rotation = rotation;
+            rect_transform.position = position;
+            boid.velocity = velocity;
+        }
+
+        if (BoidGrid::Crossed(grid, i))
+            boidThreadInfo->crossed.push_back(i);
+    }
+
+    boidThreadInfo->allocations = AllocationCounter::ThreadCount() - allocations;
+    return 0;
+}
+
+// copies a staged frame into the registry, the same ranges as the step but over spawn ids
+static int BoidThreadPresent(void *_info)
+{
+    TRACE_SCOPE("BoidThreadPresent");
+    BoidThreadInfo *boidThreadInfo = static_cast<BoidThreadInfo *>(_info);
+    const BoidFrame &frame = *boidThreadInfo->present;
+    uint64_t allocations = AllocationCounter::ThreadCount();
+
+    for (unsigned int id = boidThreadInfo->startIndex; id < boidThreadInfo->endIndex; id++)
+    {
+        auto &rect_transform = boidThreadInfo->reg->get<Canis::RectTransformComponent>((*boidThreadInfo->entitiesById)[id]);
+        rect_transform.position = frame.positions[id];
+        rect_transform.rotation = frame.rotations[id];
+    }
+
+    boidThreadInfo->allocations = AllocationCounter::ThreadCount() - allocations;
+    return 0;
+}
+
+// Everything the flock needs to step, without a window, input or scene.
+// BoidSystem drives it inside the app and the headless runner drives it directly.
+class BoidSimulation
+{
+public:
+    BoidGrid::GridData grid;
+
+    float dt;
+    entt::registry *reg;
+
+    glm::vec2 mouseWorldPosition;
+    std::vector<entt::entity> boidEntities = {}; // by grid slot
+    std::vector<uint32_t> boidIds = {}; // spawn order of each grid slot, keeps recordings and snapshots stable
+
+    std::vector<entt::entity> entitiesById = {};
+
+    // rebalance scratch, sized with the flock
+    std::vector<entt::entity> rebalanceEntities = {};
+    std::vector<uint32_t> rebalanceIds = {};
+
+    WorkerPool workers;
+    std::vector<BoidThreadInfo> threadInfos = {};
+    std::vector<BoidBatchJob> batchJobs = {};
+
+    float spawnSpeed = 0.0f;
+    Random::State random = Random::Seed(1);
+    uint64_t frame = 0;
+
+    BoidRecorder recorder;
+
+    // perception radii, the MAX_*_DISTANCE constants are the defaults
+    float cohesionDistance = MAX_COHESION_DISTANCE;
+    float alignmentDistance = MAX_ALIGNMENT_DISTANCE;
+    float separationDistance = MAX_SEPARATION_DISTANCE;
+
+    // opening angle for far field aggregation, a node further than its size / farFieldTheta is used
+    // as one boid at its centroid. 0 keeps every neighbour exact, 0.5 to 1 trades accuracy for speed
+    float farFieldTheta = 0.0f;
+
+    // with pipelined on, Step copies the last finished step into the registry and leaves the next
+    // one running on the workers while the frame is drawn. Frames cost max(sim, draw) plus the copy
+    // instead of the sum and the boids on screen are one step behind. The step writes position and
+    // rotation into staged instead of the registry the renderer reads, the copy is done before the
+    // next step is launched so one staging frame is enough. Set before the first Step.
+    bool pipelined = false;
+    bool stepInFlight = false;
+    BoidFrame staged;
+    bool stagedPending = false; // staged holds a step the registry does not show yet
+
+    // steady state frames after this many are expected not to touch the heap
+    uint64_t allocationCheckFrame = 120;
+
+    // what the workers allocated in the steps and presents that completed during this Step
+    uint64_t workerAllocations = 0;
+
+    void AddWorkerAllocations()
+    {
+        for (BoidThreadInfo &info : threadInfos)
+            workerAllocations += info.allocations;
+    }
+
+    void BuildInfo(BoidThreadInfo &_boidThreadInfo, unsigned int _currentThread) {
+        _boidThreadInfo.boidSimulation = this;
+        _boidThreadInfo.reg = reg;
+        _boidThreadInfo.boids = &boidEntities;
+        _boidThreadInfo.deltaTime = dt;
+        _boidThreadInfo.grid = &grid;
+        _boidThreadInfo.mouseWorldPosition = mouseWorldPosition;
+        _boidThreadInfo.cohesionDistance = cohesionDistance;
+        _boidThreadInfo.alignmentDistance = alignmentDistance;
+        _boidThreadInfo.separationDistance = separationDistance;
+        _boidThreadInfo.farFieldTheta = farFieldTheta;
+        _boidThreadInfo.startIndex = (boidEntities.size() * (0+_currentThread)) / threadInfos.size();
+        _boidThreadInfo.endIndex = (boidEntities.size() * (1+_currentThread)) / threadInfos.size();
+        _boidThreadInfo.crossed.reserve(_boidThreadInfo.endIndex - _boidThreadInfo.startIndex);
+        _boidThreadInfo.staged = (pipelined) ? &staged : nullptr;
+        _boidThreadInfo.boidIds = &boidIds;
+        _boidThreadInfo.entitiesById = &entitiesById;
+    }
+
+    BoidSimulation() {
+        BoidGrid::Init(grid, glm::vec2(0.0f), 2560.0f, MAX_COHESION_DISTANCE);
+    }
+
+    ~BoidSimulation() {
+        workers.Stop();
+    }
+
+    void Start(unsigned int _threadCount, uint64_t _seed)
+    {
+        random = Random::Seed(_seed);
+
+        workers.Start(_threadCount, "BoidThreadUpdate");
+
+        threadInfos.resize(_threadCount);
+        for (unsigned int i = 0; i < _threadCount; i++)
+            workers.SetArgument(i, &threadInfos[i]);
+    }
+
+    // runs _body(first, last) over [0, _count) split across the workers and the calling thread,
+    // for batch work outside Step. Works before Start too, everything then runs on the caller.
+    void ParallelFor(size_t _count, const std::function<void(size_t, size_t)> &_body)
+    {
+        Finish();
+
+        unsigned int parts = workers.Size() + 1;
+        batchJobs.resize(parts);
+        for (unsigned int i = 0; i < parts; i++)
+            batchJobs[i] = {&_body, (_count * i) / parts, (_count * (i + 1)) / parts};
+
+        for (unsigned int i = 0; i < workers.Size(); i++)
+            workers.SetArgument(i, &batchJobs[i]);
+
+        workers.Dispatch(BoidBatchThread);
+        BoidBatchThread(&batchJobs[parts - 1]);
+        workers.Wait();
+
+        for (unsigned int i = 0; i < workers.Size(); i++)
+            workers.SetArgument(i, &threadInfos[i]);
+    }
+
+    // creates _count boids in one batch, every component array is filled before a single
+    // range insert per component type
+    void SpawnBoids(entt::registry &_registry, unsigned int _count, glm::vec2 _min, glm::vec2 _max, const Canis::GLTexture *_texture)
+    {
+        const unsigned int SPAWN_CHUNK_SIZE = 4096;
+
+        std::vector<Canis::RectTransformComponent> rects(_count);
+        std::vector<BoidComponent> boids(_count);
+
+        glm::vec2 size = BoidSize(_texture);
+
+        // every chunk gets its own stream so the flock only depends on the seed, not the thread count
+        uint64_t spawnSeed = Random::Next(random);
+        size_t chunkCount = (_count + SPAWN_CHUNK_SIZE - 1) / SPAWN_CHUNK_SIZE;
+
+        ParallelFor(chunkCount, [&](size_t _firstChunk, size_t _lastChunk) {
+            for (unsigned int chunk = _firstChunk; chunk < _lastChunk; chunk++)
+            {
+                Random::State chunkRandom = Random::Fork(spawnSeed, chunk);
+                unsigned int end = std::min(_count, (chunk + 1) * SPAWN_CHUNK_SIZE);
+
+                for (unsigned int i = chunk * SPAWN_CHUNK_SIZE; i < end; i++)
+                {
+                    rects[i] = BuildRect(glm::vec2(Random::Range(chunkRandom, _min.x, _max.x), Random::Range(chunkRandom, _min.y, _max.y)), 0.0f, size);
+
+                    float angle = Random::Range(chunkRandom, 0.0f, glm::two_pi<float>());
+                    boids[i].velocity = glm::vec2(glm::cos(angle), glm::sin(angle)) * spawnSpeed;
+                }
+            }
+        });
+
+        InsertBoids(_registry, rects, boids.data(), _texture);
+    }
+
+    Canis::RectTransformComponent BuildRect(glm::vec2 _position, float _rotation, glm::vec2 _size)
+    {
+        Canis::RectTransformComponent rect;
+        rect.active = true;
+        rect.position = _position;
+        rect.rotation = _rotation;
+        rect.size = _size;
+        rect.depth = 1.0f;
+        rect.scale = 0.1f;
+        return rect;
+    }
+
+    glm::vec2 BoidSize(const Canis::GLTexture *_texture)
+    {
+        return (_texture) ? glm::vec2(_texture->width/8, _texture->height/8) : glm::vec2(0.0f);
+    }
+
+    // storage is reserved up front and the entities are created with one range create
+    void InsertBoids(entt::registry &_registry, const std::vector<Canis::RectTransformComponent> &_rects, const BoidComponent *_boids, const Canis::GLTexture *_texture)
+    {
+        Finish();
+
+        size_t first = boidEntities.size();
+        boidEntities.resize(first + _rects.size());
+
+        _registry.storage<Canis::RectTransformComponent>().reserve(boidEntities.size());
+        _registry.storage<BoidComponent>().reserve(boidEntities.size());
+
+        auto begin = boidEntities.begin() + first;
+        auto end = boidEntities.end();
+
+        _registry.create(begin, end);
+
+        BoidGrid::Reserve(grid, boidEntities.size());
+        boidIds.reserve(boidEntities.size());
+        for (size_t i = 0; i < _rects.size(); i++)
+        {
+            BoidGrid::Add(grid, _rects[i].position, _boids[i].velocity);
+            boidIds.push_back((uint32_t)boidIds.size());
+        }
+
+        rebalanceEntities.resize(boidEntities.size());
+        rebalanceIds.resize(boidEntities.size());
+        entitiesById.insert(entitiesById.end(), begin, end);
+
+        // new boids start out staged at their spawn state so the next present is complete
+        staged.positions.resize(boidEntities.size());
+        staged.rotations.resize(boidEntities.size());
+        for (size_t i = 0; i < _rects.size(); i++)
+        {
+            staged.positions[first + i] = _rects[i].position;
+            staged.rotations[first + i] = _rects[i].rotation;
+        }
+
+        _registry.insert<Canis::RectTransformComponent>(begin, end, _rects.begin());
+        _registry.insert<BoidComponent>(begin, end, _boids);
+
+        // headless runs skip everything that is only there to be drawn
+        if (_texture == nullptr)
+            return;
+
+        _registry.storage<Canis::ColorComponent>().reserve(boidEntities.size());
+        _registry.storage<Canis::Sprite2DComponent>().reserve(boidEntities.size());
+
+        _registry.insert<Canis::ColorComponent>(begin, end, Canis::ColorComponent{glm::vec4(1.0f, 1.0f, 1.0f, 1.0f)});
+        _registry.insert<Canis::Sprite2DComponent>(begin, end, Canis::Sprite2DComponent{
+            glm::vec4(0.0f, 0.0f, 1.0f, 1.0f), // uv
+            *_texture // texture
+        });
+    }
+
+    bool SaveSnapshot(entt::registry &_registry, const std::string &_path)
+    {
+        Sync(_registry);
+
+        std::vector<glm::vec2> positions(boidEntities.size());
+        std::vector<glm::vec2> velocities(boidEntities.size());
+        std::vector<float> rotations(boidEntities.size());
+
+        for (size_t slot = 0; slot < boidEntities.size(); slot++)
+        {
+            uint32_t id = boidIds[slot];
+            positions[id] = grid.positions[slot];
+            velocities[id] = grid.velocities[slot];
+            rotations[id] = _registry.get<Canis::RectTransformComponent>(boidEntities[slot]).rotation;
+        }
+
+        BoidSnapshot::Header header;
+        header.boidCount = boidEntities.size();
+        header.frame = frame;
+        header.randomState = random.state;
+
+        bool saved = BoidSnapshot::Save(_path, header, positions.data(), velocities.data(), rotations.data());
+        Canis::Log((saved ? "Saved boid snapshot " : "Failed to save boid snapshot ") + _path);
+        return saved;
+    }
+
+    // maps the snapshot and inserts the velocities straight out of the mapping
+    bool RestoreSnapshot(entt::registry &_registry, const std::string &_path, const Canis::GLTexture *_texture)
+    {
+        static_assert(sizeof(BoidComponent) == sizeof(glm::vec2), "BoidComponent is loaded straight from the snapshot");
+
+        auto start = std::chrono::high_resolution_clock::now();
+
+        BoidSnapshot::MappedFile file;
+        BoidSnapshot::View view;
+        if (!BoidSnapshot::Map(_path, file))
+            return false;
+
+        if (!BoidSnapshot::Open(file, view))
+        {
+            Canis::Log("Ignoring invalid boid snapshot " + _path);
+            BoidSnapshot::Unmap(file);
+            return false;
+        }
+
+        size_t count = view.header->boidCount;
+        glm::vec2 size = BoidSize(_texture);
+
+        std::vector<Canis::RectTransformComponent> rects(count);
+        ParallelFor(count, [&](size_t _first, size_t _last) {
+            for (size_t i = _first; i < _last; i++)
+                rects[i] = BuildRect(view.positions[i], view.rotations[i], size);
+        });
+
+        InsertBoids(_registry, rects, reinterpret_cast<const BoidComponent *>(view.velocities), _texture);
+
+        frame = view.header->frame;
+        random.state = view.header->randomState;
+
+        BoidSnapshot::Unmap(file);
+
+        auto end = std::chrono::high_resolution_clock::now();
+        Canis::Log("Restored " + std::to_string(count) + " boids from " + _path + " in " +
+            std::to_string(std::chrono::duration<double, std::milli>(end - start).count()) + " ms");
+        return true;
+    }
+
+    // one frame of the flock, every boid steers towards _seekTarget
+    void Step(entt::registry &_registry, float _deltaTime, glm::vec2 _seekTarget)
+    {
+        // this thread's share plus the workers' share of every step completed in here, in
+        // pipelined mode that is the step launched last frame
+        uint64_t allocations = AllocationCounter::ThreadCount();
+        workerAllocations = 0;
+
+        if (pipelined)
+        {
+            // the step launched last frame normally finished while that frame was drawn
+            Finish();
+            Present(_registry);
+            Launch(_registry, _deltaTime, _seekTarget);
+        }
+        else
+        {
+            Launch(_registry, _deltaTime, _seekTarget);
+            Finish();
+        }
+
+        allocations = AllocationCounter::ThreadCount() - allocations + workerAllocations;
+        if (AllocationCounter::Enabled() && frame > allocationCheckFrame && allocations != 0)
+        {
+            Canis::FatalError("Boid frame " + std::to_string(frame) + " made " +
+                std::to_string(allocations) + " heap allocations");
+        }
+    }
+
+    // starts the next step on the workers and returns straight away
+    void Launch(entt::registry &_registry, float _deltaTime, glm::vec2 _seekTarget)
+    {
+        frame++;
+
+        if (BoidGrid::NeedsRebalance(grid))
+            Rebalance();
+
+        if (farFieldTheta > 0.0f)
+        {
+            TRACE_SCOPE("BoidSimulation::Aggregate");
+            BoidGrid::Aggregate(grid);
+        }
+
+        dt = _deltaTime;
+        reg = &_registry;
+        mouseWorldPosition = _seekTarget;
+
+        for (unsigned int i = 0; i < threadInfos.size(); i++)
+            BuildInfo(threadInfos[i], i);
+
+        workers.Dispatch(BoidThreadUpdate);
+        stepInFlight = true;
+    }
+
+    // waits for the launched step and makes its result the current state
+    void Finish()
+    {
+        if (!stepInFlight)
+            return;
+
+        workers.Wait();
+        stepInFlight = false;
+        AddWorkerAllocations();
+
+        {
+            // only the boids that changed cell touch the index
+            TRACE_SCOPE("BoidSimulation::RelocateBoids");
+            BoidGrid::Swap(grid);
+            for (BoidThreadInfo &info : threadInfos)
+                BoidGrid::Relocate(grid, info.crossed);
+        }
+
+        stagedPending = pipelined;
+
+        RecordFrame();
+    }
+
+    // copies the finished step into the registry on the workers, has to be done before the
+    // next step is launched since that one writes staged again
+    void Present(entt::registry &_registry)
+    {
+        if (!stagedPending)
+            return;
+
+        stagedPending = false;
+        TRACE_SCOPE("BoidSimulation::Present");
+
+        reg = &_registry;
+        for (unsigned int i = 0; i < threadInfos.size(); i++)
+        {
+            BuildInfo(threadInfos[i], i);
+            threadInfos[i].present = &staged;
+        }
+
+        workers.Dispatch(BoidThreadPresent);
+        workers.Wait();
+        AddWorkerAllocations();
+    }
+
+    // nothing running and the registry showing the current state, for anything that reads both
+    void Sync(entt::registry &_registry)
+    {
+        Finish();
+        if (pipelined)
+            Present(_registry);
+    }
+
+    // current positions in spawn order
+    void GatherPositions(std::vector<glm::vec2> &_positions)
+    {
+        _positions.resize(boidIds.size());
+        for (size_t slot = 0; slot < boidIds.size(); slot++)
+            _positions[boidIds[slot]] = grid.positions[slot];
+    }
+
+    // current velocities in spawn order
+    void GatherVelocities(std::vector<glm::vec2> &_velocities)
+    {
+        _velocities.resize(boidIds.size());
+        for (size_t slot = 0; slot < boidIds.size(); slot++)
+            _velocities[boidIds[slot]] = grid.velocities[slot];
+    }
+
+    // scales every radius so cohesion reaches _radius, separation stays as it is since it only
+    // matters up close
+    void SetPerceptionRadius(float _radius)
+    {
+        alignmentDistance = _radius * (MAX_ALIGNMENT_DISTANCE / MAX_COHESION_DISTANCE);
+        cohesionDistance = _radius;
+    }
+
+    // puts the slots back in cell order once enough boids wandered off, the entity and id of
+    // each slot move with it
+    void Rebalance()
+    {
+        TRACE_SCOPE("BoidSimulation::Rebalance");
+
+        BoidGrid::Rebalance(grid, [&](const std::vector<uint32_t> &_order) {
+            for (size_t slot = 0; slot < _order.size(); slot++)
+            {
+                rebalanceEntities[slot] = boidEntities[_order[slot]];
+                rebalanceIds[slot] = boidIds[_order[slot]];
+            }
+            boidEntities.swap(rebalanceEntities);
+            boidIds.swap(rebalanceIds);
+        });
+    }
+
+    void ToggleRecording(const std::string &_path)
+    {
+        if (recorder.IsRecording())
+        {
+            recorder.Stop();
+            Canis::Log("Stopped recording " + _path + " frames written: " + std::to_string(recorder.written) +
+                " dropped: " + std::to_string(recorder.dropped));
+            return;
+        }
+
+        if (recorder.Start(_path, boidEntities.size()))
+            Canis::Log("Recording boids to " + _path);
+        else
+            Canis::Log("Failed to open " + _path);
+    }
+
+    // copies this frame into a free recorder buffer, skipped when the writer is behind
+    void RecordFrame()
+    {
+        BoidRecorder::Frame *recordFrame = recorder.Acquire();
+        if (recordFrame == nullptr)
+            return;
+
+        recordFrame->frame = frame;
+        for (size_t slot = 0; slot < boidEntities.size(); slot++)
+        {
+            recordFrame->positions[boidIds[slot]] = grid.positions[slot];
+            recordFrame->velocities[boidIds[slot]] = grid.velocities[slot];
+        }
+
+        recorder.Submit();
+    }
+};
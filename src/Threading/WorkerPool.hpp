@@ -0,0 +1,150 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <memory>
+#include <semaphore>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <pthread.h>
+#endif
+
+#include "../Debug/Trace.hpp"
+
+// Persistent worker threads. Each worker sleeps on its own semaphore, runs the dispatched task
+// with the argument bound to it and signals the pool when done, so a frame never creates threads.
+// Only the standard library is used so life_bench, which has no SDL, shares it with the app.
+class WorkerPool
+{
+public:
+    // same shape as SDL_ThreadFunction
+    using Task = int (*)(void *);
+
+private:
+    struct Worker
+    {
+        WorkerPool *pool = nullptr;
+        std::thread thread;
+        std::binary_semaphore start{0};
+        void *argument = nullptr;
+    };
+
+    std::vector<std::unique_ptr<Worker>> m_workers = {};
+    std::counting_semaphore<> m_done{0};
+    Task m_task = nullptr;
+    unsigned int m_dispatched = 0;
+    std::atomic<bool> m_quit = false;
+
+    static inline std::atomic<unsigned int> s_running = 0;
+
+    static void WorkerLoop(Worker *_worker)
+    {
+        WorkerPool *pool = _worker->pool;
+
+        // the trace buffer is taken before the first task so no traced task allocates it
+        Trace::RegisterThread();
+        pool->m_done.release();
+
+        while (true)
+        {
+            _worker->start.acquire();
+
+            if (pool->m_quit.load(std::memory_order_acquire))
+                break;
+
+            pool->m_task(_worker->argument);
+            pool->m_done.release();
+        }
+    }
+
+public:
+    ~WorkerPool()
+    {
+        Stop();
+    }
+
+    unsigned int Size() const
+    {
+        return m_workers.size();
+    }
+
+    // workers of every pool in the process, for sizing a pool next to the others
+    static unsigned int Running()
+    {
+        return s_running.load(std::memory_order_relaxed);
+    }
+
+    void Start(unsigned int _threadCount, const char *_name)
+    {
+        Stop();
+
+        m_quit = false;
+        m_workers.resize(_threadCount);
+
+        for (std::unique_ptr<Worker> &worker : m_workers)
+        {
+            worker = std::make_unique<Worker>();
+            worker->pool = this;
+            worker->thread = std::thread(WorkerLoop, worker.get());
+
+#ifdef __linux__
+            // shows up in debuggers and profilers like the SDL threads did, 15 characters at most
+            char name[16] = {};
+            std::copy_n(_name, std::min<size_t>(std::char_traits<char>::length(_name), 15), name);
+            pthread_setname_np(worker->thread.native_handle(), name);
+#else
+            (void)_name;
+#endif
+        }
+
+        // every worker has registered by the time the first task is dispatched
+        for (size_t i = 0; i < m_workers.size(); i++)
+            m_done.acquire();
+
+        s_running += _threadCount;
+    }
+
+    void Stop()
+    {
+        if (m_workers.empty())
+            return;
+
+        Wait();
+
+        m_quit.store(true, std::memory_order_release);
+        for (std::unique_ptr<Worker> &worker : m_workers)
+            worker->start.release();
+
+        for (std::unique_ptr<Worker> &worker : m_workers)
+            worker->thread.join();
+
+        s_running -= m_workers.size();
+        m_workers.clear();
+    }
+
+    // the argument worker _index passes to every task, has to stay valid while the pool runs
+    void SetArgument(unsigned int _index, void *_argument)
+    {
+        m_workers[_index]->argument = _argument;
+    }
+
+    // wakes the first _count workers (all of them by default) and returns straight away
+    void Dispatch(Task _task, unsigned int _count = UINT_MAX)
+    {
+        m_task = _task;
+        m_dispatched = std::min(_count, (unsigned int)m_workers.size());
+
+        for (unsigned int i = 0; i < m_dispatched; i++)
+            m_workers[i]->start.release();
+    }
+
+    // blocks until every dispatched task returned
+    void Wait()
+    {
+        for (; m_dispatched > 0; m_dispatched--)
+            m_done.acquire();
+    }
+};
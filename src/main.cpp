@@ -20,11 +20,183 @@
 
 #include "ECS/Systems/GameOfLifeSystem.hpp"
 #include "ECS/Systems/BoidSystem.hpp"
+#include "ECS/Systems/SystemScheduler.hpp"
+
+#include "DemoOptions.hpp"
+#include "Headless.hpp"
+
+#include "Debug/Trace.hpp"
+#include "Debug/TracedSystem.hpp"
+#include "Debug/FrameLog.hpp"
+#include "Debug/AllocationCounter.hpp"
+
+#ifdef CANIS_DEMOS_COUNT_ALLOCATIONS
+#include <cstdlib>
+#include <new>
+
+// every form of operator new goes through one of these two, so none of them slips past the count
+static void *CountedAlloc(std::size_t _size) noexcept
+{
+    AllocationCounter::ThreadCounter()++;
+    return std::malloc(_size ? _size : 1);
+}
+
+static void *CountedAlignedAlloc(std::size_t _size, std::align_val_t _alignment) noexcept
+{
+    AllocationCounter::ThreadCounter()++;
+    // aligned_alloc wants a size that is a multiple of the alignment
+    std::size_t alignment = static_cast<std::size_t>(_alignment);
+    std::size_t size = ((_size ? _size : 1) + alignment - 1) / alignment * alignment;
+    return std::aligned_alloc(alignment, size);
+}
+
+void *operator new(std::size_t _size)
+{
+    if (void *memory = CountedAlloc(_size))
+        return memory;
+    throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t _size)
+{
+    return operator new(_size);
+}
+
+void *operator new(std::size_t _size, const std::nothrow_t &) noexcept
+{
+    return CountedAlloc(_size);
+}
+
+void *operator new[](std::size_t _size, const std::nothrow_t &) noexcept
+{
+    return CountedAlloc(_size);
+}
+
+void *operator new(std::size_t _size, std::align_val_t _alignment)
+{
+    if (void *memory = CountedAlignedAlloc(_size, _alignment))
+        return memory;
+    throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t _size, std::align_val_t _alignment)
+{
+    return operator new(_size, _alignment);
+}
+
+void *operator new(std::size_t _size, std::align_val_t _alignment, const std::nothrow_t &) noexcept
+{
+    return CountedAlignedAlloc(_size, _alignment);
+}
+
+void *operator new[](std::size_t _size, std::align_val_t _alignment, const std::nothrow_t &) noexcept
+{
+    return CountedAlignedAlloc(_size, _alignment);
+}
+
+void operator delete(void *_memory) noexcept
+{
+    std::free(_memory);
+}
+
+void operator delete[](void *_memory) noexcept
+{
+    std::free(_memory);
+}
+
+void operator delete(void *_memory, std::size_t) noexcept
+{
+    std::free(_memory);
+}
+
+void operator delete[](void *_memory, std::size_t) noexcept
+{
+    std::free(_memory);
+}
+
+void operator delete(void *_memory, const std::nothrow_t &) noexcept
+{
+    std::free(_memory);
+}
+
+void operator delete[](void *_memory, const std::nothrow_t &) noexcept
+{
+    std::free(_memory);
+}
+
+void operator delete(void *_memory, std::align_val_t) noexcept
+{
+    std::free(_memory);
+}
+
+void operator delete[](void *_memory, std::align_val_t) noexcept
+{
+    std::free(_memory);
+}
+
+void operator delete(void *_memory, std::size_t, std::align_val_t) noexcept
+{
+    std::free(_memory);
+}
+
+void operator delete[](void *_memory, std::size_t, std::align_val_t) noexcept
+{
+    std::free(_memory);
+}
+
+void operator delete(void *_memory, std::align_val_t, const std::nothrow_t &) noexcept
+{
+    std::free(_memory);
+}
+
+void operator delete[](void *_memory, std::align_val_t, const std::nothrow_t &) noexcept
+{
+    std::free(_memory);
+}
+#endif
 
 int main(int argc, char* argv[])
 {
+    DemoOptions &options = GetDemoOptions();
+    if (!ParseDemoOptions(argc, argv, options))
+    {
+        PrintDemoUsage();
+        return 1;
+    }
+
+    // --trace or CANIS_TRACE=trace.json records a Chrome trace
+    bool tracing = Trace::ConfigureFromEnvironment();
+    if (!options.tracePath.empty())
+    {
+        uint64_t lastFrame = (options.traceLastFrame > 0) ? options.traceLastFrame : options.traceFirstFrame + 120;
+        Trace::Configure(options.tracePath, options.traceFirstFrame, lastFrame);
+        tracing = true;
+    }
+    Trace::LimitFrames(options.frames);
+
+    if (options.headless)
+    {
+        int result = Headless::Run(options);
+        Trace::Flush();
+        return result;
+    }
+
+    if (options.frames > 0)
+        GetFrameLog().Reserve(options.frames);
+
     Canis::App app;
 
+    // the scheduler takes the update systems before either list below sees them
+    if (options.parallelSystems)
+        app.AddDecodeSystem(DecodeScheduledSystem);
+
+    // the traced engine systems have to be registered first so they win over the plain ones
+    if (tracing)
+    {
+        app.AddDecodeSystem(DecodeTracedSystem);
+        app.AddDecodeRenderSystem(DecodeTracedRenderSystem);
+    }
+
     // decode system
     app.AddDecodeSystem(Canis::DecodeButtonSystem);
     app.AddDecodeSystem(Canis::DecodeCollisionSystem2D);
@@ -59,7 +231,8 @@ int main(int argc, char* argv[])
     app.AddScene(new Canis::Scene("game_of_life", "assets/scenes/game_of_life.scene"));
     app.AddScene(new Canis::Scene("boid_demo", "assets/scenes/boid_demo.scene"));
 
-    app.Run("Canis Demos", "boid_demo");
+    app.Run("Canis Demos", options.scene);
+    Trace::Flush();
 
     return 0;
 }
\ No newline at end of file